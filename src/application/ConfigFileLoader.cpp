@@ -132,6 +132,7 @@ ConfigFileLoader::ConfigFileLoader() :
 	ADD_INT_PARAM	(world.seed,						ConfigParam::UNITS_NONE);
 	ADD_INT_PARAM	(world.matingSeasonDuration,		ConfigParam::UNITS_TIME);
 	ADD_INT_PARAM	(world.offSeasonDuration,			ConfigParam::UNITS_TIME);
+	ADD_INT_PARAM	(world.numThreads,					ConfigParam::UNITS_NONE);
 	
 	// Plants
 	ADD_FLOAT_PARAM	(plant.radius,						ConfigParam::UNITS_DISTANCE);
@@ -204,16 +205,37 @@ ConfigFileLoader::ConfigFileLoader() :
 
 	// Neurological genes
 	ADD_SPECIES_INT_PARAM	(genes.maxInternalNeurons,			ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(genes.useFastSpawning,				ConfigParam::UNITS_NONE);
+
+	// Vision config
+	ADD_SPECIES_BOOL_PARAM	(vision.useAnalyticProjection,		ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.useBatchKernel,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.verifyBatchKernel,			ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.frontToBack,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_INT_PARAM	(vision.updateInterval,				ConfigParam::UNITS_TIME);
+	ADD_SPECIES_BOOL_PARAM	(vision.staggerUpdates,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.useCellLists,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.cullBehind,					ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.cullBeyondHorizon,			ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(vision.useSpecializedKernels,		ConfigParam::UNITS_NONE);
 
 	// Brain config
 	ADD_SPECIES_INT_PARAM	(brain.numPrebirthCycles,			ConfigParam::UNITS_NONE);
 	ADD_SPECIES_FLOAT_PARAM	(brain.maxBias,						ConfigParam::UNITS_NONE);
 	ADD_SPECIES_FLOAT_PARAM	(brain.sigmoidSlope,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_INT_PARAM	(brain.sigmoidFunction,				ConfigParam::UNITS_NONE);
 	ADD_SPECIES_FLOAT_PARAM	(brain.maxWeight,					ConfigParam::UNITS_NONE);
 	ADD_SPECIES_FLOAT_PARAM	(brain.initMaxWeight,				ConfigParam::UNITS_NONE);
 	ADD_SPECIES_FLOAT_PARAM	(brain.weightLearningRate,			ConfigParam::UNITS_NONE);
 	ADD_SPECIES_FLOAT_PARAM	(brain.weightDecayRate,				ConfigParam::UNITS_NONE);
 	ADD_SPECIES_BOOL_PARAM	(brain.useHebbianLearning,			ConfigParam::UNITS_NONE);
+	ADD_SPECIES_INT_PARAM	(brain.hebbianLearningInterval,		ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(brain.useDenseWeights,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_INT_PARAM	(brain.weightPrecision,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(brain.useSpecializedKernels,		ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(brain.useBatchedUpdate,			ConfigParam::UNITS_NONE);
+	ADD_SPECIES_BOOL_PARAM	(brain.pruneNetwork,				ConfigParam::UNITS_NONE);
+	ADD_SPECIES_INT_PARAM	(brain.topologyCacheSize,			ConfigParam::UNITS_NONE);
 	
 	//-------------------------------------------------------------------------
 	// Units
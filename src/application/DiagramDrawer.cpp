@@ -23,6 +23,7 @@ void DiagramDrawer::DrawBrainMatrix(Graphics& g, Agent* agent, const Rect2f& bou
 	const SpeciesConfig& config = m_simulationManager->
 		GetSimulation()->GetAgentConfig(agent->GetSpecies());
 	Brain* brain = agent->GetBrain();
+	brain->SyncWeights();
 
 	unsigned int numNeurons = brain->GetNumNeurons();
 	unsigned int numInputNeurons = brain->GetNumInputNeurons();
@@ -0,0 +1,145 @@
+#include "BenchmarkBrains.h"
+#include <utilities/Timing.h>
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+BenchmarkBrains::BenchmarkBrains() :
+	m_useBatchedUpdate(false),
+	m_numInputFrames(0)
+{
+}
+
+BenchmarkBrains::~BenchmarkBrains()
+{
+	DeleteBrains();
+}
+
+
+//-----------------------------------------------------------------------------
+// Genomes
+//-----------------------------------------------------------------------------
+
+void BenchmarkBrains::AddRandomGenomes(std::vector<const Genome*>& genomes,
+	const SpeciesConfig& config, unsigned int numGenomes, RNG& random)
+{
+	for (unsigned int i = 0; i < numGenomes; ++i)
+	{
+		Genome* genome = new Genome(config);
+		genome->Randomize(random);
+		genomes.push_back(genome);
+	}
+}
+
+void BenchmarkBrains::ReleaseGenomes(std::vector<const Genome*>& genomes)
+{
+	for (unsigned int i = 0; i < genomes.size(); ++i)
+		genomes[i]->Release();
+	genomes.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+void BenchmarkBrains::Grow(const std::vector<const Genome*>& genomes,
+	const SpeciesConfig& config, RNG& random)
+{
+	DeleteBrains();
+	m_useBatchedUpdate = config.brain.useBatchedUpdate;
+
+	for (unsigned int i = 0; i < genomes.size(); ++i)
+	{
+		RNG growRandom(random.NextInt());
+		Brain* brain = new Brain();
+		genomes[i]->GrowBrain(brain, growRandom, config);
+		if (m_useBatchedUpdate)
+			m_batch.AddBrain(brain);
+		m_brains.push_back(brain);
+	}
+}
+
+void BenchmarkBrains::GenerateInputs(unsigned int numFrames, RNG& random)
+{
+	m_numInputFrames = numFrames;
+	m_inputs.clear();
+	if (m_brains.empty())
+		return;
+
+	unsigned int numInputs = m_brains[0]->GetNumInputNeurons();
+	m_inputs.resize(numFrames * m_brains.size() * numInputs);
+	for (unsigned int i = 0; i < m_inputs.size(); ++i)
+		m_inputs[i] = random.NextFloat();
+}
+
+double BenchmarkBrains::Update(unsigned int numUpdates, std::vector<float>* outOutputs)
+{
+	unsigned int numBrains = m_brains.size();
+	if (numBrains == 0)
+		return 0.0;
+	unsigned int numInputs = m_brains[0]->GetNumInputNeurons();
+	unsigned int numOutputs = m_brains[0]->GetNumOutputNeurons();
+	if (outOutputs != nullptr)
+		outOutputs->resize(numUpdates * numBrains * numOutputs);
+
+	double elapsedTime = 0.0;
+	for (unsigned int update = 0; update < numUpdates; ++update)
+	{
+		if (m_numInputFrames > 0)
+		{
+			const float* frameInputs = m_inputs.data() +
+				((update % m_numInputFrames) * numBrains * numInputs);
+			for (unsigned int i = 0; i < numBrains; ++i)
+			{
+				for (unsigned int k = 0; k < numInputs; ++k)
+					m_brains[i]->SetNeuronActivation(k, frameInputs[(i * numInputs) + k]);
+			}
+		}
+
+		double startTime = Time::GetTime();
+		if (m_useBatchedUpdate)
+		{
+			for (unsigned int i = 0; i < numBrains; ++i)
+			{
+				if (m_brains[i]->IsBatched())
+					m_batch.Submit(m_brains[i]);
+				else
+					m_brains[i]->Update();
+			}
+			m_batch.Update();
+		}
+		else
+		{
+			for (unsigned int i = 0; i < numBrains; ++i)
+				m_brains[i]->Update();
+		}
+		elapsedTime += Time::GetTime() - startTime;
+
+		if (outOutputs != nullptr)
+		{
+			float* updateOutputs = outOutputs->data() + (update * numBrains * numOutputs);
+			for (unsigned int i = 0; i < numBrains; ++i)
+			{
+				for (unsigned int k = 0; k < numOutputs; ++k)
+				{
+					updateOutputs[(i * numOutputs) + k] =
+						m_brains[i]->GetNeuronActivation(numInputs + k);
+				}
+			}
+		}
+	}
+	return elapsedTime;
+}
+
+void BenchmarkBrains::DeleteBrains()
+{
+	// Brains remove themselves from the batch when deleted.
+	for (unsigned int i = 0; i < m_brains.size(); ++i)
+		delete m_brains[i];
+	m_brains.clear();
+	m_inputs.clear();
+	m_numInputFrames = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef _BENCHMARK_BRAINS_H_
+#define _BENCHMARK_BRAINS_H_
+
+#include <simulation/Brain.h>
+#include <simulation/BrainBatch.h>
+#include <simulation/Genome.h>
+#include <simulation/SimulationConfig.h>
+#include <utilities/Random.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// BenchmarkBrains - A set of brains grown from genomes for the benchmarks.
+//                   Each brain is grown with its own seed, so sets grown
+//                   from the same genomes and seed with different brain
+//                   settings start out with the same weights. Inputs are
+//                   generated up front, so only the updates are timed.
+//-----------------------------------------------------------------------------
+class BenchmarkBrains
+{
+public:
+	BenchmarkBrains();
+	~BenchmarkBrains();
+
+	// Add the given number of random genomes for a species config. Release
+	// them with ReleaseGenomes().
+	static void AddRandomGenomes(std::vector<const Genome*>& genomes,
+		const SpeciesConfig& config, unsigned int numGenomes, RNG& random);
+	static void ReleaseGenomes(std::vector<const Genome*>& genomes);
+
+	unsigned int GetNumBrains() const { return m_brains.size(); }
+	Brain* GetBrain(unsigned int index) { return m_brains[index]; }
+
+	// Grow a brain from each genome with the given species config,
+	// replacing any brains grown before. Each brain's seed is drawn from the
+	// given generator. Brains are batched if the config enables batched
+	// updates.
+	void Grow(const std::vector<const Genome*>& genomes,
+		const SpeciesConfig& config, RNG& random);
+
+	// Generate the given number of frames of random inputs for every brain,
+	// which are fed to the brains in turn on each update.
+	void GenerateInputs(unsigned int numFrames, RNG& random);
+
+	// Feed the brains their inputs and update them for the given number of
+	// ticks, returning the time spent updating them, in seconds. If given,
+	// the outputs of every brain are recorded after each update.
+	double Update(unsigned int numUpdates, std::vector<float>* outOutputs = nullptr);
+
+	void DeleteBrains();
+
+
+private:
+	std::vector<Brain*>	m_brains;
+	BrainBatch			m_batch;
+	bool				m_useBatchedUpdate;
+	std::vector<float>	m_inputs;
+	unsigned int		m_numInputFrames;
+};
+
+
+#endif // _BENCHMARK_BRAINS_H_
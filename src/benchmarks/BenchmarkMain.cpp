@@ -0,0 +1,115 @@
+#include "VisionBenchmark.h"
+#include "SigmoidBenchmark.h"
+#include "PrecisionBenchmark.h"
+#include "BrainBenchmark.h"
+#include "SpawnBenchmark.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+//-----------------------------------------------------------------------------
+// Benchmarks
+//-----------------------------------------------------------------------------
+
+// Usage: SEALBench vision <simulation file> [iterations] [tolerance]
+static int RunVisionBenchmark(int argc, char** argv)
+{
+	if (argc < 1)
+	{
+		printf("Usage: SEALBench vision <simulation file> [iterations] [tolerance]\n");
+		return 1;
+	}
+
+	unsigned int numIterations = (argc > 1 ? (unsigned int) atoi(argv[1]) : 1000);
+	float tolerance = (argc > 2 ? (float) atof(argv[2]) : 0.0f);
+
+	VisionBenchmark benchmark;
+	if (!benchmark.Load(argv[0]))
+		return 1;
+	return (benchmark.Run(numIterations, tolerance) ? 0 : 2);
+}
+
+// Usage: SEALBench sigmoid [iterations] [brains] [seed]
+static int RunSigmoidBenchmark(int argc, char** argv)
+{
+	unsigned int numIterations = (argc > 0 ? (unsigned int) atoi(argv[0]) : 1000);
+	unsigned int numBrains = (argc > 1 ? (unsigned int) atoi(argv[1]) : 64);
+	unsigned int seed = (argc > 2 ? (unsigned int) atoi(argv[2]) : 1);
+
+	SigmoidBenchmark benchmark;
+	benchmark.Init(numBrains, seed);
+	benchmark.Run(numIterations);
+	return 0;
+}
+
+// Usage: SEALBench precision [updates] [brains] [seed]
+static int RunPrecisionBenchmark(int argc, char** argv)
+{
+	unsigned int numUpdates = (argc > 0 ? (unsigned int) atoi(argv[0]) : 1000);
+	unsigned int numBrains = (argc > 1 ? (unsigned int) atoi(argv[1]) : 64);
+	unsigned int seed = (argc > 2 ? (unsigned int) atoi(argv[2]) : 1);
+
+	// Learning changes weights every update, which reduced precision can't
+	// always represent, so compare brains with and without learning. With
+	// learning, 8-bit brains are stored with 16-bit floats.
+	PrecisionBenchmark benchmark;
+	benchmark.Init(numBrains, seed, true);
+	benchmark.Run(numUpdates, seed);
+	benchmark.Init(numBrains, seed, false);
+	benchmark.Run(numUpdates, seed);
+	return 0;
+}
+
+// Usage: SEALBench brain [updates] [brains] [seed] [simulation file]
+static int RunBrainBenchmark(int argc, char** argv)
+{
+	unsigned int numUpdates = (argc > 0 ? (unsigned int) atoi(argv[0]) : 1000);
+	unsigned int numBrains = (argc > 1 ? (unsigned int) atoi(argv[1]) : 64);
+	unsigned int seed = (argc > 2 ? (unsigned int) atoi(argv[2]) : 1);
+
+	BrainBenchmark benchmark;
+	benchmark.AddRandomGenomes(numBrains, seed);
+	if (argc > 3 && !benchmark.AddSavedGenomes(argv[3], numBrains))
+		return 1;
+	benchmark.Run(numUpdates, seed);
+	return 0;
+}
+
+// Usage: SEALBench spawn [children] [seed]
+static int RunSpawnBenchmark(int argc, char** argv)
+{
+	unsigned int numChildren = (argc > 0 ? (unsigned int) atoi(argv[0]) : 100000);
+	unsigned int seed = (argc > 1 ? (unsigned int) atoi(argv[1]) : 1);
+
+	SpawnBenchmark benchmark;
+	return (benchmark.Run(numChildren, seed) ? 0 : 2);
+}
+
+
+//-----------------------------------------------------------------------------
+// Main
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	if (argc >= 2 && strcmp(argv[1], "vision") == 0)
+		return RunVisionBenchmark(argc - 2, argv + 2);
+	if (argc >= 2 && strcmp(argv[1], "sigmoid") == 0)
+		return RunSigmoidBenchmark(argc - 2, argv + 2);
+	if (argc >= 2 && strcmp(argv[1], "precision") == 0)
+		return RunPrecisionBenchmark(argc - 2, argv + 2);
+	if (argc >= 2 && strcmp(argv[1], "brain") == 0)
+		return RunBrainBenchmark(argc - 2, argv + 2);
+	if (argc >= 2 && strcmp(argv[1], "spawn") == 0)
+		return RunSpawnBenchmark(argc - 2, argv + 2);
+
+	printf("Usage: SEALBench <benchmark> [arguments]\n");
+	printf("Benchmarks:\n");
+	printf("  vision <simulation file> [iterations] [tolerance]\n");
+	printf("  sigmoid [iterations] [brains] [seed]\n");
+	printf("  precision [updates] [brains] [seed]\n");
+	printf("  brain [updates] [brains] [seed] [simulation file]\n");
+	printf("  spawn [children] [seed]\n");
+	return 1;
+}
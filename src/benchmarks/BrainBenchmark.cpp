@@ -0,0 +1,202 @@
+#include "BrainBenchmark.h"
+#include "BenchmarkBrains.h"
+#include <simulation/Simulation.h>
+#include <utilities/Random.h>
+#include <fstream>
+#include <stdio.h>
+
+
+// The brain engines to measure, from the reference implementation to the
+// fastest ones.
+static const BrainBenchmarkEngine BRAIN_BENCHMARK_ENGINES[] =
+{
+	// name				dense	special	batched	prune	precision
+	{ "sparse",			false,	false,	false,	false,	WEIGHT_PRECISION_FLOAT32 },
+	{ "pruned",			false,	false,	false,	true,	WEIGHT_PRECISION_FLOAT32 },
+	{ "dense",			true,	false,	false,	false,	WEIGHT_PRECISION_FLOAT32 },
+	{ "specialized",	true,	true,	false,	false,	WEIGHT_PRECISION_FLOAT32 },
+	{ "float16",		true,	false,	false,	false,	WEIGHT_PRECISION_FLOAT16 },
+	{ "int8",			true,	false,	false,	false,	WEIGHT_PRECISION_INT8 },
+	{ "batched",		true,	false,	true,	false,	WEIGHT_PRECISION_FLOAT32 },
+};
+
+// The brain sizes of the random genomes, as the max sight resolution and
+// the max number of internal neurons.
+static const unsigned int BRAIN_BENCHMARK_SIZES[][2] =
+{
+	{ 1,	5 },
+	{ 3,	10 },
+	{ 6,	20 },
+	{ 10,	40 },
+};
+
+// The number of different sets of inputs fed to each brain, in turn.
+static const unsigned int NUM_INPUT_FRAMES = 64;
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+BrainBenchmark::BrainBenchmark()
+{
+}
+
+BrainBenchmark::~BrainBenchmark()
+{
+	DeleteGenomes();
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+void BrainBenchmark::AddRandomGenomes(unsigned int numBrains, unsigned int seed)
+{
+	SimulationConfig simulationConfig;
+	RNG random(seed);
+	char name[64];
+
+	unsigned int numSizes = sizeof(BRAIN_BENCHMARK_SIZES) / sizeof(BRAIN_BENCHMARK_SIZES[0]);
+	for (unsigned int size = 0; size < numSizes; ++size)
+	{
+		BrainBenchmarkGenomes* genomeSet = new BrainBenchmarkGenomes();
+		genomeSet->config = simulationConfig.herbivore;
+		genomeSet->config.genes.maxSightResolution = BRAIN_BENCHMARK_SIZES[size][0];
+		genomeSet->config.genes.maxInternalNeurons = BRAIN_BENCHMARK_SIZES[size][1];
+		sprintf(name, "random genomes, resolution %u, %u internal neurons",
+			BRAIN_BENCHMARK_SIZES[size][0], BRAIN_BENCHMARK_SIZES[size][1]);
+		genomeSet->name = name;
+		BenchmarkBrains::AddRandomGenomes(genomeSet->genomes,
+			genomeSet->config, numBrains, random);
+		m_genomeSets.push_back(genomeSet);
+	}
+}
+
+bool BrainBenchmark::AddSavedGenomes(const std::string& fileName, unsigned int maxBrains)
+{
+	std::ifstream fileIn;
+	fileIn.open(fileName, std::ios::in | std::ios::binary);
+	if (!fileIn)
+	{
+		printf("Error: could not open the file '%s'\n", fileName.c_str());
+		return false;
+	}
+
+	Simulation* simulation = new Simulation();
+	if (!simulation->ReadSimulation(fileIn))
+	{
+		printf("Error: '%s' is not a valid simulation file\n", fileName.c_str());
+		delete simulation;
+		return false;
+	}
+
+	// Share the genomes of each species' agents, in the order they're stored.
+	const char* speciesNames[SPECIES_COUNT] = { "herbivore", "carnivore" };
+	BrainBenchmarkGenomes* genomeSets[SPECIES_COUNT];
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		genomeSets[i] = new BrainBenchmarkGenomes();
+		genomeSets[i]->config = simulation->GetAgentConfig((Species) i);
+		genomeSets[i]->name = std::string("saved ") + speciesNames[i] + " genomes";
+	}
+	ObjectManager* objectManager = simulation->GetObjectManager();
+	for (auto it = objectManager->agents_begin(); it != objectManager->agents_end(); ++it)
+	{
+		std::vector<const Genome*>& genomes = genomeSets[it->GetSpecies()]->genomes;
+		if (genomes.size() < maxBrains)
+		{
+			it->GetGenome()->AddReference();
+			genomes.push_back(it->GetGenome());
+		}
+	}
+	delete simulation;
+
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		if (genomeSets[i]->genomes.empty())
+			delete genomeSets[i];
+		else
+			m_genomeSets.push_back(genomeSets[i]);
+	}
+	return true;
+}
+
+void BrainBenchmark::Run(unsigned int numUpdates, unsigned int seed)
+{
+	unsigned int numEngines = sizeof(BRAIN_BENCHMARK_ENGINES) / sizeof(BRAIN_BENCHMARK_ENGINES[0]);
+	printf("Brain benchmark: %u updates, single thread\n", numUpdates);
+
+	for (unsigned int i = 0; i < m_genomeSets.size(); ++i)
+	{
+		const BrainBenchmarkGenomes& genomeSet = *m_genomeSets[i];
+		printf("\n%s: %u brains\n", genomeSet.name.c_str(), (unsigned int) genomeSet.genomes.size());
+		printf("%-9s %-12s %10s %10s %12s %14s\n", "learning", "engine",
+			"neurons", "synapses", "ns/update", "updates/s/core");
+
+		for (unsigned int learning = 0; learning < 2; ++learning)
+		{
+			for (unsigned int engine = 0; engine < numEngines; ++engine)
+			{
+				RunEngine(genomeSet, BRAIN_BENCHMARK_ENGINES[engine],
+					(learning == 0), numUpdates, seed);
+			}
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+void BrainBenchmark::RunEngine(const BrainBenchmarkGenomes& genomeSet,
+	const BrainBenchmarkEngine& engine, bool useHebbianLearning,
+	unsigned int numUpdates, unsigned int seed)
+{
+	unsigned int numBrains = genomeSet.genomes.size();
+	if (numBrains == 0 || numUpdates == 0)
+		return;
+
+	SpeciesConfig config = genomeSet.config;
+	config.brain.useHebbianLearning = useHebbianLearning;
+	config.brain.useDenseWeights = engine.useDenseWeights;
+	config.brain.useSpecializedKernels = engine.useSpecializedKernels;
+	config.brain.useBatchedUpdate = engine.useBatchedUpdate;
+	config.brain.pruneNetwork = engine.pruneNetwork;
+	config.brain.weightPrecision = engine.weightPrecision;
+
+	// Grow every engine's brains with the same seeds, so they start out
+	// with the same weights, and feed them the same inputs.
+	RNG random(seed);
+	BenchmarkBrains brains;
+	brains.Grow(genomeSet.genomes, config, random);
+	brains.GenerateInputs(NUM_INPUT_FRAMES, random);
+	double numNeurons = 0.0;
+	double numSynapses = 0.0;
+	for (unsigned int i = 0; i < numBrains; ++i)
+	{
+		numNeurons += brains.GetBrain(i)->GetNumConnectedNeurons();
+		numSynapses += brains.GetBrain(i)->GetNumSynapses();
+	}
+
+	double elapsedTime = brains.Update(numUpdates);
+
+	double numAgentUpdates = (double) numUpdates * numBrains;
+	printf("%-9s %-12s %10.1f %10.1f %12.1f %14.0f\n",
+		useHebbianLearning ? "on" : "off", engine.name,
+		numNeurons / numBrains, numSynapses / numBrains,
+		(elapsedTime * 1.0e9) / numAgentUpdates,
+		elapsedTime > 0.0 ? numAgentUpdates / elapsedTime : 0.0);
+}
+
+void BrainBenchmark::DeleteGenomes()
+{
+	for (unsigned int i = 0; i < m_genomeSets.size(); ++i)
+	{
+		BenchmarkBrains::ReleaseGenomes(m_genomeSets[i]->genomes);
+		delete m_genomeSets[i];
+	}
+	m_genomeSets.clear();
+}
@@ -0,0 +1,76 @@
+#ifndef _BRAIN_BENCHMARK_H_
+#define _BRAIN_BENCHMARK_H_
+
+#include <simulation/Brain.h>
+#include <simulation/Genome.h>
+#include <simulation/SimulationConfig.h>
+#include <string>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// BrainBenchmarkEngine - A combination of brain settings to measure.
+//-----------------------------------------------------------------------------
+struct BrainBenchmarkEngine
+{
+	const char*		name;
+	bool			useDenseWeights;
+	bool			useSpecializedKernels;
+	bool			useBatchedUpdate;
+	bool			pruneNetwork;
+	WeightPrecision	weightPrecision;
+};
+
+
+//-----------------------------------------------------------------------------
+// BrainBenchmarkGenomes - A set of genomes to grow brains from, along with
+//                         the species config they were made for.
+//-----------------------------------------------------------------------------
+struct BrainBenchmarkGenomes
+{
+	std::string				name;
+	SpeciesConfig			config;
+	std::vector<const Genome*>	genomes;
+};
+
+
+//-----------------------------------------------------------------------------
+// BrainBenchmark - Measures the throughput of brain updates. Brains are
+//                  grown from sets of random genomes covering a range of
+//                  brain sizes, and optionally from the genomes of the
+//                  agents in a saved simulation. Each set is grown with
+//                  every brain engine, with and without Hebbian learning,
+//                  and fed the same random inputs. The results are given as
+//                  agent updates per second on a single core.
+//-----------------------------------------------------------------------------
+class BrainBenchmark
+{
+public:
+	BrainBenchmark();
+	~BrainBenchmark();
+
+	// Add sets of random genomes for each of the benchmark's brain sizes.
+	void AddRandomGenomes(unsigned int numBrains, unsigned int seed);
+
+	// Add a set of genomes for each species of the agents in a saved
+	// simulation, with up to the given number of genomes in each.
+	bool AddSavedGenomes(const std::string& fileName, unsigned int maxBrains);
+
+	// Update brains grown from every set of genomes with every engine, for
+	// the given number of ticks, printing the results.
+	void Run(unsigned int numUpdates, unsigned int seed);
+
+
+private:
+	void RunEngine(const BrainBenchmarkGenomes& genomeSet,
+		const BrainBenchmarkEngine& engine, bool useHebbianLearning,
+		unsigned int numUpdates, unsigned int seed);
+	void DeleteGenomes();
+
+
+private:
+	std::vector<BrainBenchmarkGenomes*> m_genomeSets;
+};
+
+
+#endif // _BRAIN_BENCHMARK_H_
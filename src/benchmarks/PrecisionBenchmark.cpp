@@ -0,0 +1,110 @@
+#include "PrecisionBenchmark.h"
+#include <utilities/Random.h>
+#include <math/MathLib.h>
+#include <stdio.h>
+
+
+static const char* WEIGHT_PRECISION_NAMES[NUM_WEIGHT_PRECISIONS] =
+{
+	"float32",
+	"float16",
+	"int8",
+};
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+PrecisionBenchmark::PrecisionBenchmark()
+{
+	// Batching would keep the weights in 32-bit floats.
+	m_config.herbivore.brain.useBatchedUpdate = false;
+}
+
+PrecisionBenchmark::~PrecisionBenchmark()
+{
+	BenchmarkBrains::ReleaseGenomes(m_genomes);
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+void PrecisionBenchmark::Init(unsigned int numBrains, unsigned int seed, bool useHebbianLearning)
+{
+	m_config.herbivore.brain.useHebbianLearning = useHebbianLearning;
+
+	RNG random(seed);
+	SpeciesConfig speciesConfig = m_config.herbivore;
+	BenchmarkBrains::ReleaseGenomes(m_genomes);
+	BenchmarkBrains::AddRandomGenomes(m_genomes, speciesConfig, numBrains, random);
+
+	// Grow each precision's brains with the same seeds, so their weights
+	// start out equal.
+	unsigned int growSeed = random.NextInt();
+	for (unsigned int precision = 0; precision < NUM_WEIGHT_PRECISIONS; ++precision)
+	{
+		RNG growRandom(growSeed);
+		speciesConfig.brain.weightPrecision = precision;
+		m_brains[precision].Grow(m_genomes, speciesConfig, growRandom);
+	}
+}
+
+void PrecisionBenchmark::Run(unsigned int numUpdates, unsigned int seed)
+{
+	BenchmarkBrains& referenceBrains = m_brains[WEIGHT_PRECISION_FLOAT32];
+	unsigned int numBrains = referenceBrains.GetNumBrains();
+	printf("Precision benchmark: %u brains, %u updates, learning %s\n",
+		numBrains, numUpdates,
+		m_config.herbivore.brain.useHebbianLearning ? "on" : "off");
+	if (numBrains == 0 || numUpdates == 0)
+		return;
+
+	printf("%-10s %10s %12s %12s %12s %12s\n", "precision", "bytes",
+		"ns/update", "max output", "mean output", "max weight");
+
+	// Record the outputs of every update.
+	std::vector<float> outputs[NUM_WEIGHT_PRECISIONS];
+
+	for (unsigned int precision = 0; precision < NUM_WEIGHT_PRECISIONS; ++precision)
+	{
+		// Generate different inputs for every update up front, the same for
+		// each precision, so each one is timed on the same work.
+		BenchmarkBrains& brains = m_brains[precision];
+		RNG random(seed);
+		brains.GenerateInputs(numUpdates, random);
+		double elapsedNs = brains.Update(numUpdates, &outputs[precision]) * 1.0e9;
+
+		// Compare the outputs and the learned weights with 32-bit weights.
+		float maxOutputDiff = 0.0f;
+		double totalOutputDiff = 0.0;
+		for (unsigned int i = 0; i < outputs[precision].size(); ++i)
+		{
+			float diff = Math::Abs(outputs[precision][i] - outputs[WEIGHT_PRECISION_FLOAT32][i]);
+			maxOutputDiff = Math::Max(maxOutputDiff, diff);
+			totalOutputDiff += diff;
+		}
+		float maxWeightDiff = 0.0f;
+		unsigned int totalBytes = 0;
+		for (unsigned int i = 0; i < numBrains; ++i)
+		{
+			Brain* brain = brains.GetBrain(i);
+			Brain* referenceBrain = referenceBrains.GetBrain(i);
+			brain->SyncWeights();
+			referenceBrain->SyncWeights();
+			for (unsigned int k = 0; k < brain->GetNumSynapses(); ++k)
+			{
+				maxWeightDiff = Math::Max(maxWeightDiff, Math::Abs(
+					brain->GetSynapse(k).weight - referenceBrain->GetSynapse(k).weight));
+			}
+			totalBytes += brain->GetMemorySize();
+		}
+
+		printf("%-10s %10u %12.1f %12.3g %12.3g %12.3g\n",
+			WEIGHT_PRECISION_NAMES[precision], totalBytes / numBrains,
+			elapsedNs / ((double) numUpdates * numBrains), maxOutputDiff,
+			totalOutputDiff / outputs[precision].size(), maxWeightDiff);
+	}
+}
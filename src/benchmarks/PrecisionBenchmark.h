@@ -0,0 +1,41 @@
+#ifndef _PRECISION_BENCHMARK_H_
+#define _PRECISION_BENCHMARK_H_
+
+#include "BenchmarkBrains.h"
+#include <simulation/SimulationConfig.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// PrecisionBenchmark - Compares brains storing their weights with reduced
+//                      precision against the same brains with 32-bit
+//                      weights. Brains are grown from random genomes with a
+//                      fixed seed, once for each weight precision, then all
+//                      copies of a brain are fed the same random inputs. The
+//                      differences in their outputs and learned weights are
+//                      reported along with their memory use and update time.
+//-----------------------------------------------------------------------------
+class PrecisionBenchmark
+{
+public:
+	PrecisionBenchmark();
+	~PrecisionBenchmark();
+
+	// Grow the brains to compare, with the given random seed, and with or
+	// without Hebbian learning.
+	void Init(unsigned int numBrains, unsigned int seed, bool useHebbianLearning);
+
+	// Update the brains for the given number of ticks, printing the results.
+	void Run(unsigned int numUpdates, unsigned int seed);
+
+
+private:
+	SimulationConfig			m_config;
+	std::vector<const Genome*>	m_genomes;
+
+	// The brains grown with each weight precision, in the same order.
+	BenchmarkBrains				m_brains[NUM_WEIGHT_PRECISIONS];
+};
+
+
+#endif // _PRECISION_BENCHMARK_H_
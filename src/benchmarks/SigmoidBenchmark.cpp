@@ -0,0 +1,138 @@
+#include "SigmoidBenchmark.h"
+#include <utilities/Random.h>
+#include <utilities/Timing.h>
+#include <math.h>
+#include <stdio.h>
+
+
+// The range and resolution of inputs over which the error is measured.
+static const float SIGMOID_ERROR_RANGE = 20.0f;
+static const unsigned int SIGMOID_ERROR_STEPS = 400000;
+
+// The number of values in the array which is timed.
+static const unsigned int SIGMOID_ARRAY_SIZE = 4096;
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+SigmoidBenchmark::SigmoidBenchmark()
+{
+	// A batch keeps the sigmoid function of the brains it was made with.
+	m_config.herbivore.brain.useBatchedUpdate = false;
+}
+
+SigmoidBenchmark::~SigmoidBenchmark()
+{
+	BenchmarkBrains::ReleaseGenomes(m_genomes);
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+void SigmoidBenchmark::Init(unsigned int numBrains, unsigned int seed)
+{
+	RNG random(seed);
+	SpeciesConfig& speciesConfig = m_config.herbivore;
+	BenchmarkBrains::ReleaseGenomes(m_genomes);
+	BenchmarkBrains::AddRandomGenomes(m_genomes, speciesConfig, numBrains, random);
+	m_brains.Grow(m_genomes, speciesConfig, random);
+	m_brains.GenerateInputs(1, random);
+
+	// Spread the array's values over the range seen by neurons.
+	m_values.resize(SIGMOID_ARRAY_SIZE);
+	for (unsigned int i = 0; i < SIGMOID_ARRAY_SIZE; ++i)
+		m_values[i] = random.NextFloat(-8.0f, 8.0f);
+}
+
+void SigmoidBenchmark::Run(unsigned int numIterations)
+{
+	unsigned int numBrains = m_brains.GetNumBrains();
+	unsigned int numSynapses = 0;
+	for (unsigned int i = 0; i < numBrains; ++i)
+		numSynapses += m_brains.GetBrain(i)->GetNumSynapses();
+	printf("Sigmoid benchmark: %u brains (%.0f synapses per brain), "
+		"%u iterations\n", numBrains,
+		numBrains == 0 ? 0.0f : (float) numSynapses / numBrains,
+		numIterations);
+	if (numIterations == 0)
+		return;
+
+	printf("%-12s %12s %12s %12s %12s\n", "function", "max error",
+		"mean error", "ns/value", "ns/brain");
+
+	for (unsigned int i = 0; i < NUM_SIGMOID_FUNCTIONS; ++i)
+	{
+		SigmoidFunction function = (SigmoidFunction) i;
+		double maxError;
+		double meanError;
+		MeasureError(function, maxError, meanError);
+		double nsPerValue = TimeArray(function, numIterations);
+		double nsPerBrain = TimeBrains(function, numIterations);
+		printf("%-12s %12.3g %12.3g %12.2f %12.1f\n",
+			SigmoidFunctions::GetName(function), maxError, meanError,
+			nsPerValue, nsPerBrain);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+void SigmoidBenchmark::MeasureError(SigmoidFunction function,
+	double& outMaxError, double& outMeanError)
+{
+	outMaxError = 0.0;
+	outMeanError = 0.0;
+
+	// Evaluate a whole array at once, so the SIMD paths are measured.
+	std::vector<float> values(SIGMOID_ERROR_STEPS + 1);
+	for (unsigned int i = 0; i <= SIGMOID_ERROR_STEPS; ++i)
+	{
+		values[i] = -SIGMOID_ERROR_RANGE + ((2.0f * SIGMOID_ERROR_RANGE * i) /
+			SIGMOID_ERROR_STEPS);
+	}
+	std::vector<float> inputs = values;
+	SigmoidFunctions::Apply(function, values.data(), values.size(), 1.0f);
+
+	for (unsigned int i = 0; i <= SIGMOID_ERROR_STEPS; ++i)
+	{
+		double expected = 1.0 / (1.0 + exp(-(double) inputs[i]));
+		double error = fabs(values[i] - expected);
+		if (error > outMaxError)
+			outMaxError = error;
+		outMeanError += error;
+	}
+	outMeanError /= values.size();
+}
+
+double SigmoidBenchmark::TimeArray(SigmoidFunction function, unsigned int numIterations)
+{
+	// Apply the sigmoid to a copy each time, so the inputs stay the same.
+	std::vector<float> values(m_values.size());
+	double startTime = Time::GetTime();
+	for (unsigned int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		values = m_values;
+		SigmoidFunctions::Apply(function, values.data(), values.size(), 1.0f);
+	}
+	double elapsedNs = (Time::GetTime() - startTime) * 1.0e9;
+	return (elapsedNs / ((double) numIterations * m_values.size()));
+}
+
+double SigmoidBenchmark::TimeBrains(SigmoidFunction function, unsigned int numIterations)
+{
+	unsigned int numBrains = m_brains.GetNumBrains();
+	if (numBrains == 0)
+		return 0.0;
+
+	for (unsigned int i = 0; i < numBrains; ++i)
+		m_brains.GetBrain(i)->SetSigmoidFunction(function);
+
+	double elapsedNs = m_brains.Update(numIterations) * 1.0e9;
+	return (elapsedNs / ((double) numIterations * numBrains));
+}
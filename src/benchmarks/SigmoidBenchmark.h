@@ -0,0 +1,44 @@
+#ifndef _SIGMOID_BENCHMARK_H_
+#define _SIGMOID_BENCHMARK_H_
+
+#include "BenchmarkBrains.h"
+#include <simulation/SimulationConfig.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// SigmoidBenchmark - Compares the sigmoid implementations. Each one is
+//                    measured for its error against a double-precision
+//                    sigmoid, for its speed on a plain array of values, and
+//                    for the speed of whole brain updates grown from random
+//                    genomes with the default species config.
+//-----------------------------------------------------------------------------
+class SigmoidBenchmark
+{
+public:
+	SigmoidBenchmark();
+	~SigmoidBenchmark();
+
+	// Grow the brains to update, with the given random seed.
+	void Init(unsigned int numBrains, unsigned int seed);
+
+	// Measure every sigmoid implementation, printing the results.
+	void Run(unsigned int numIterations);
+
+
+private:
+	void MeasureError(SigmoidFunction function, double& outMaxError,
+		double& outMeanError);
+	double TimeArray(SigmoidFunction function, unsigned int numIterations);
+	double TimeBrains(SigmoidFunction function, unsigned int numIterations);
+
+
+private:
+	SimulationConfig			m_config;
+	std::vector<const Genome*>	m_genomes;
+	BenchmarkBrains				m_brains;
+	std::vector<float>			m_values;
+};
+
+
+#endif // _SIGMOID_BENCHMARK_H_
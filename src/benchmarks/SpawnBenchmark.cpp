@@ -0,0 +1,242 @@
+#include "SpawnBenchmark.h"
+#include <utilities/Random.h>
+#include <utilities/Timing.h>
+#include <math.h>
+#include <stdio.h>
+
+
+// The mutation rate and crossover points genes to compare, covering the
+// lowest, middle and highest values of each.
+static const SpawnBenchmarkCase SPAWN_BENCHMARK_CASES[] =
+{
+	// rate	points
+	{ 128,	128 },
+	{ 0,	0 },
+	{ 255,	255 },
+	{ 40,	200 },
+	{ 200,	90 },
+};
+
+// A test fails when its p-value is below this, so with the 20 tests run by
+// default, a correct tree fails with a chance of about 0.2%.
+static const double MIN_P_VALUE = 1.0e-4;
+
+// Histogram bins with fewer children than this between both ways are left
+// out of the chi-square, as its approximation doesn't hold for them.
+static const unsigned int MIN_HISTOGRAM_BIN_COUNT = 10;
+
+// The number of children spawned between reading the time.
+static const unsigned int SPAWN_BATCH_SIZE = 256;
+
+
+static unsigned int CountBits(unsigned char value)
+{
+	unsigned int count = 0;
+	for (; value != 0; value >>= 1)
+		count += (value & 1);
+	return count;
+}
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+SpawnBenchmark::SpawnBenchmark()
+{
+	SimulationConfig simulationConfig;
+	m_config = simulationConfig.herbivore;
+}
+
+SpawnBenchmark::~SpawnBenchmark()
+{
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+bool SpawnBenchmark::Run(unsigned int numChildren, unsigned int seed)
+{
+	unsigned int numCases = sizeof(SPAWN_BENCHMARK_CASES) / sizeof(SPAWN_BENCHMARK_CASES[0]);
+	printf("Spawn benchmark: %u children per case, %d genes\n",
+		numChildren, Genome::DetermineGenomeSize(m_config));
+	if (numChildren == 0)
+		return true;
+
+	printf("P-values of the chi-square tests, failing below %g:\n", MIN_P_VALUE);
+	printf("%5s %7s %14s %14s %9s %9s %9s %9s  %s\n", "rate", "points",
+		"ns/child ref", "ns/child fast", "origin", "mutation", "switches",
+		"mutations", "result");
+
+	RNG random(seed);
+	bool passed = true;
+	for (unsigned int i = 0; i < numCases; ++i)
+	{
+		const SpawnBenchmarkCase& spawnCase = SPAWN_BENCHMARK_CASES[i];
+		SpawnStatistics reference;
+		SpawnStatistics fast;
+		Spawn(spawnCase, false, numChildren, random, reference);
+		Spawn(spawnCase, true, numChildren, random, fast);
+
+		double pValues[4];
+		pValues[0] = CompareFrequencies(reference.secondParentCounts,
+			fast.secondParentCounts, numChildren);
+		pValues[1] = CompareFrequencies(reference.mutationCounts,
+			fast.mutationCounts, numChildren);
+		pValues[2] = CompareHistograms(reference.switchHistogram, fast.switchHistogram);
+		pValues[3] = CompareHistograms(reference.mutationHistogram, fast.mutationHistogram);
+
+		bool casePassed = true;
+		for (unsigned int k = 0; k < 4; ++k)
+			casePassed = casePassed && (pValues[k] >= MIN_P_VALUE);
+		passed = passed && casePassed;
+
+		printf("%5u %7u %14.1f %14.1f %9.3g %9.3g %9.3g %9.3g  %s\n",
+			spawnCase.mutationRate, spawnCase.crossoverPoints,
+			(reference.elapsedTime * 1.0e9) / numChildren,
+			(fast.elapsedTime * 1.0e9) / numChildren,
+			pValues[0], pValues[1], pValues[2], pValues[3],
+			casePassed ? "ok" : "FAILED");
+	}
+	return passed;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+void SpawnBenchmark::Spawn(const SpawnBenchmarkCase& spawnCase,
+	bool useFastSpawning, unsigned int numChildren, RNG& random,
+	SpawnStatistics& outStatistics)
+{
+	SpeciesConfig config = m_config;
+	config.genes.useFastSpawning = useFastSpawning;
+
+	// Make parents with all bits clear and all bits set, other than their
+	// shared mutation rate and crossover points.
+	Genome* parents[2] = { new Genome(config), new Genome(config) };
+	unsigned int genomeSize = parents[0]->GetSize();
+	for (unsigned int k = 0; k < genomeSize; ++k)
+	{
+		parents[0]->GetData()[k] = 0x00;
+		parents[1]->GetData()[k] = 0xFF;
+	}
+	for (unsigned int p = 0; p < 2; ++p)
+	{
+		parents[p]->GetData()[MUTATION_RATE] = spawnCase.mutationRate;
+		parents[p]->GetData()[CROSSOVER_POINTS] = spawnCase.crossoverPoints;
+	}
+
+	outStatistics.secondParentCounts.assign(genomeSize, 0);
+	outStatistics.mutationCounts.assign(genomeSize, 0);
+	outStatistics.switchHistogram.assign(genomeSize + 1, 0);
+	outStatistics.mutationHistogram.assign(genomeSize + 1, 0);
+	outStatistics.elapsedTime = 0.0;
+
+	std::vector<Genome*> children(SPAWN_BATCH_SIZE);
+	for (unsigned int first = 0; first < numChildren; first += SPAWN_BATCH_SIZE)
+	{
+		unsigned int batchSize = numChildren - first;
+		if (batchSize > SPAWN_BATCH_SIZE)
+			batchSize = SPAWN_BATCH_SIZE;
+
+		double startTime = Time::GetTime();
+		for (unsigned int i = 0; i < batchSize; ++i)
+			children[i] = Genome::SpawnChild(parents[0], parents[1], config, random);
+		outStatistics.elapsedTime += Time::GetTime() - startTime;
+
+		// The parents' shared genes tell nothing about where a gene came
+		// from, or whether it mutated, so they're left out.
+		for (unsigned int i = 0; i < batchSize; ++i)
+		{
+			const unsigned char* genes = children[i]->GetData();
+			unsigned int numSwitches = 0;
+			unsigned int numMutations = 0;
+			int prevParent = -1;
+			for (unsigned int k = 0; k < genomeSize; ++k)
+			{
+				if (k == MUTATION_RATE || k == CROSSOVER_POINTS)
+					continue;
+				unsigned int numBits = CountBits(genes[k]);
+				int parent = (numBits >= 7 ? 1 : 0);
+				if (numBits == 1 || numBits == 7)
+				{
+					outStatistics.mutationCounts[k]++;
+					numMutations++;
+				}
+				outStatistics.secondParentCounts[k] += parent;
+				if (prevParent >= 0 && parent != prevParent)
+					numSwitches++;
+				prevParent = parent;
+			}
+			outStatistics.switchHistogram[numSwitches]++;
+			outStatistics.mutationHistogram[numMutations]++;
+			children[i]->Release();
+		}
+	}
+
+	parents[0]->Release();
+	parents[1]->Release();
+}
+
+// Compare how often each gene has a property in two equally sized samples,
+// with a chi-square test for each gene. Neighbouring genes often come from
+// the same parent, so the tests aren't independent, and the smallest
+// p-value is corrected for their number (Bonferroni). Genes which never or
+// always have the property in both samples are left out.
+double SpawnBenchmark::CompareFrequencies(const std::vector<unsigned int>& a,
+	const std::vector<unsigned int>& b, unsigned int numChildren)
+{
+	double maxChiSquare = 0.0;
+	unsigned int numTests = 0;
+	for (unsigned int k = 0; k < a.size(); ++k)
+	{
+		double pa = (double) a[k] / numChildren;
+		double pb = (double) b[k] / numChildren;
+		double pooled = (pa + pb) * 0.5;
+		if (pooled <= 0.0 || pooled >= 1.0)
+			continue;
+		double chiSquare = ((pa - pb) * (pa - pb)) /
+			(pooled * (1.0 - pooled) * 2.0 / numChildren);
+		if (chiSquare > maxChiSquare)
+			maxChiSquare = chiSquare;
+		numTests++;
+	}
+	if (numTests == 0)
+		return 1.0;
+
+	// A chi-square with one degree of freedom is a squared normal variable.
+	double pValue = erfc(sqrt(maxChiSquare * 0.5)) * numTests;
+	return (pValue < 1.0 ? pValue : 1.0);
+}
+
+// Compare two histograms of equally sized samples with a chi-square test of
+// homogeneity, returning its p-value.
+double SpawnBenchmark::CompareHistograms(const std::vector<unsigned int>& a,
+	const std::vector<unsigned int>& b)
+{
+	double chiSquare = 0.0;
+	unsigned int numBins = 0;
+	for (unsigned int k = 0; k < a.size(); ++k)
+	{
+		double total = (double) a[k] + b[k];
+		if (total < MIN_HISTOGRAM_BIN_COUNT)
+			continue;
+		double diff = (double) a[k] - b[k];
+		chiSquare += (diff * diff) / total;
+		numBins++;
+	}
+	if (numBins <= 1)
+		return 1.0;
+
+	// Find the upper tail of the chi-square distribution with the
+	// Wilson-Hilferty approximation, which is close enough for any
+	// p-value near the threshold.
+	unsigned int degreesOfFreedom = numBins - 1;
+	double variance = 2.0 / (9.0 * degreesOfFreedom);
+	double z = (pow(chiSquare / degreesOfFreedom, 1.0 / 3.0) - (1.0 - variance)) / sqrt(variance);
+	return (0.5 * erfc(z / sqrt(2.0)));
+}
@@ -0,0 +1,68 @@
+#ifndef _SPAWN_BENCHMARK_H_
+#define _SPAWN_BENCHMARK_H_
+
+#include <simulation/Genome.h>
+#include <simulation/SimulationConfig.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// SpawnBenchmarkCase - The mutation rate and crossover points genes shared
+//                      by both parents.
+//-----------------------------------------------------------------------------
+struct SpawnBenchmarkCase
+{
+	unsigned char	mutationRate;
+	unsigned char	crossoverPoints;
+};
+
+
+//-----------------------------------------------------------------------------
+// SpawnBenchmark - Checks that the fast and reference ways of spawning a
+//                  child genome give children from the same distribution,
+//                  and measures the time each one takes. The parents have
+//                  all bits clear and all bits set, so the parent each gene
+//                  came from, and whether it mutated (flipping one bit),
+//                  can be read from the number of bits set in it. The two
+//                  ways are compared with chi-square tests on how often
+//                  each gene comes from the second parent, how often each
+//                  gene mutates, and the histograms of the number of parent
+//                  switches and of mutations per child. Each test gives a
+//                  p-value, and the check fails if any is too small.
+//-----------------------------------------------------------------------------
+class SpawnBenchmark
+{
+public:
+	SpawnBenchmark();
+	~SpawnBenchmark();
+
+	// Spawn the given number of children each way for every case, printing
+	// the results. Returns false if any statistic differs between the two
+	// ways by more than chance allows.
+	bool Run(unsigned int numChildren, unsigned int seed);
+
+
+private:
+	struct SpawnStatistics
+	{
+		std::vector<unsigned int>	secondParentCounts; // per gene
+		std::vector<unsigned int>	mutationCounts; // per gene
+		std::vector<unsigned int>	switchHistogram;
+		std::vector<unsigned int>	mutationHistogram;
+		double						elapsedTime;
+	};
+
+	void Spawn(const SpawnBenchmarkCase& spawnCase, bool useFastSpawning,
+		unsigned int numChildren, RNG& random, SpawnStatistics& outStatistics);
+	static double CompareFrequencies(const std::vector<unsigned int>& a,
+		const std::vector<unsigned int>& b, unsigned int numChildren);
+	static double CompareHistograms(const std::vector<unsigned int>& a,
+		const std::vector<unsigned int>& b);
+
+
+private:
+	SpeciesConfig	m_config;
+};
+
+
+#endif // _SPAWN_BENCHMARK_H_
@@ -0,0 +1,267 @@
+#include "VisionBenchmark.h"
+#include <simulation/Agent.h>
+#include <simulation/Brain.h>
+#include <utilities/Timing.h>
+#include <math/MathLib.h>
+#include <fstream>
+#include <stdio.h>
+
+
+// The vision modes to replay, from the reference implementation to the
+// fastest one.
+static const VisionBenchmarkMode VISION_BENCHMARK_MODES[] =
+{
+	// name						analytic	batch	specialized
+	{ "perspective",			false,		false,	false },
+	{ "analytic",				true,		false,	false },
+	{ "batch",					true,		true,	false },
+	{ "batch + specialized",	true,		true,	true },
+};
+
+// The exact (analytic) and approximate (batch) projections place span edges
+// within about 2e-5 of the field of view of each other, so an edge pixel
+// only rarely rounds the other way. Up to this fraction of the sight values
+// drawn with one of them may differ from those drawn with the other.
+static const float MAX_APPROXIMATE_MISMATCH_FRACTION = 0.001f;
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+VisionBenchmark::VisionBenchmark() :
+	m_simulation(nullptr),
+	m_numSightValues(0)
+{
+}
+
+VisionBenchmark::~VisionBenchmark()
+{
+	delete m_simulation;
+	m_simulation = nullptr;
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+bool VisionBenchmark::Load(const std::string& fileName)
+{
+	std::ifstream fileIn;
+	fileIn.open(fileName, std::ios::in | std::ios::binary);
+	if (!fileIn)
+	{
+		printf("Error: could not open the file '%s'\n", fileName.c_str());
+		return false;
+	}
+
+	delete m_simulation;
+	m_simulation = new Simulation();
+	if (!m_simulation->ReadSimulation(fileIn))
+	{
+		printf("Error: '%s' is not a valid simulation file\n", fileName.c_str());
+		return false;
+	}
+	fileIn.close();
+	m_simulation->OnNewSimulation();
+
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+		m_originalConfigs[i] = m_simulation->GetAgentConfig((Species) i);
+
+	CaptureCandidates();
+
+	// Draw the reference retinas with the simulation's own settings.
+	SeeAll();
+	ReadSightValues(m_referenceSightValues);
+	return true;
+}
+
+bool VisionBenchmark::Run(unsigned int numIterations, float tolerance)
+{
+	unsigned int numAgents = m_samples.size();
+	unsigned int numCandidates = m_candidates.size();
+	printf("Vision benchmark: %u agents, %u candidates (%.1f per agent), "
+		"%u sight values, %u iterations\n", numAgents, numCandidates,
+		numAgents > 0 ? (float) numCandidates / numAgents : 0.0f,
+		m_numSightValues, numIterations);
+	if (numAgents == 0 || numIterations == 0)
+		return true;
+
+	printf("%-22s %12s %14s %10s %12s  %s\n", "mode", "ns/agent",
+		"ns/candidate", "mismatches", "max diff", "check");
+
+	bool passed = true;
+	std::vector<float> sightValues;
+	unsigned int numModes = sizeof(VISION_BENCHMARK_MODES) / sizeof(VisionBenchmarkMode);
+	for (unsigned int modeIndex = 0; modeIndex < numModes; ++modeIndex)
+	{
+		const VisionBenchmarkMode& mode = VISION_BENCHMARK_MODES[modeIndex];
+		ApplyMode(mode);
+
+		// Warm up, and check the retinas against the reference. Each agent
+		// is checked according to how its species' projection in this mode
+		// compares to the reference one.
+		SeeAll();
+		ReadSightValues(sightValues);
+		unsigned int numMismatches = 0;
+		unsigned int numExactMismatches = 0;
+		unsigned int numApproximateMismatches = 0;
+		unsigned int numExactValues = 0;
+		unsigned int numApproximateValues = 0;
+		float maxDiff = 0.0f;
+		for (unsigned int i = 0; i < m_samples.size(); ++i)
+		{
+			const AgentSample& sample = m_samples[i];
+			ProjectionMatch match = CompareProjection(mode,
+				m_originalConfigs[sample.agent->GetSpecies()]);
+			if (match == PROJECTION_EXACT)
+				numExactValues += sample.numSightValues;
+			else if (match == PROJECTION_APPROXIMATE)
+				numApproximateValues += sample.numSightValues;
+
+			for (unsigned int j = 0; j < sample.numSightValues; ++j)
+			{
+				unsigned int index = sample.firstSightValue + j;
+				float diff = Math::Abs(sightValues[index] - m_referenceSightValues[index]);
+				maxDiff = Math::Max(maxDiff, diff);
+				if (diff <= tolerance)
+					continue;
+				numMismatches++;
+				if (match == PROJECTION_EXACT)
+					numExactMismatches++;
+				else if (match == PROJECTION_APPROXIMATE)
+					numApproximateMismatches++;
+			}
+		}
+
+		// Modes with the same projection kernel as the reference must match
+		// it, and the exact and approximate analytic projections must match
+		// each other within the allowed fraction. The perspective projection
+		// rounds many span edges differently, so it isn't checked.
+		bool modePassed = (numExactMismatches == 0 &&
+			numApproximateMismatches <= numApproximateValues * MAX_APPROXIMATE_MISMATCH_FRACTION);
+		if (!modePassed)
+			passed = false;
+		const char* check = "-";
+		if (numExactValues > 0 && numApproximateValues > 0)
+			check = "exact + approximate";
+		else if (numExactValues > 0)
+			check = "exact";
+		else if (numApproximateValues > 0)
+			check = "approximate";
+
+		// Time the replays.
+		double startTime = Time::GetTime();
+		for (unsigned int iteration = 0; iteration < numIterations; ++iteration)
+			SeeAll();
+		double elapsedNs = (Time::GetTime() - startTime) * 1.0e9;
+
+		double nsPerAgent = elapsedNs / ((double) numIterations * numAgents);
+		double nsPerCandidate = (numCandidates > 0 ?
+			elapsedNs / ((double) numIterations * numCandidates) : 0.0);
+		printf("%-22s %12.1f %14.2f %10u %12g  %s%s\n", mode.name, nsPerAgent,
+			nsPerCandidate, numMismatches, maxDiff, check,
+			(modePassed ? "" : "  FAILED"));
+	}
+
+	RestoreConfig();
+	return passed;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+// Compare the projection kernel used by a mode to the one used by a species'
+// own settings. Only the analytic projection has a batch kernel, and the
+// specialized kernels only change how spans are drawn.
+VisionBenchmark::ProjectionMatch VisionBenchmark::CompareProjection(
+	const VisionBenchmarkMode& mode, const SpeciesConfig& config)
+{
+	if (mode.useAnalyticProjection != config.vision.useAnalyticProjection)
+		return PROJECTION_DIFFERENT;
+	if (mode.useAnalyticProjection &&
+		mode.useBatchKernel != config.vision.useBatchKernel)
+		return PROJECTION_APPROXIMATE;
+	return PROJECTION_EXACT;
+}
+
+// Gather the visible objects within each agent's vision range, the same way
+// Agent::UpdateVision() does on a vision refresh tick.
+void VisionBenchmark::CaptureCandidates()
+{
+	ObjectManager* objectManager = m_simulation->GetObjectManager();
+	OctTree* octTree = objectManager->GetOctTree();
+
+	m_samples.clear();
+	m_candidates.clear();
+	m_numSightValues = 0;
+
+	for (auto it = objectManager->agents_begin(); it != objectManager->agents_end(); ++it)
+	{
+		Agent* agent = *it;
+		AgentSample sample;
+		sample.agent = agent;
+		sample.firstCandidate = m_candidates.size();
+		sample.firstSightValue = m_numSightValues;
+		sample.numSightValues = agent->GetBrain()->GetNumInputNeurons() -
+			NUM_NON_SIGHT_INPUTS;
+
+		Sphere visionSphere(agent->GetPosition(), agent->GetMaxViewDistance());
+		octTree->Query(visionSphere, [&](SimulationObject* object)
+		{
+			if (object != agent && !object->GetInOrbit() && object->IsVisible())
+				m_candidates.push_back(object);
+		});
+
+		sample.numCandidates = m_candidates.size() - sample.firstCandidate;
+		m_numSightValues += sample.numSightValues;
+		m_samples.push_back(sample);
+	}
+}
+
+void VisionBenchmark::ApplyMode(const VisionBenchmarkMode& mode)
+{
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		SpeciesConfig& config = m_simulation->GetAgentConfig((Species) i);
+		config.vision = m_originalConfigs[i].vision;
+		config.vision.useAnalyticProjection = mode.useAnalyticProjection;
+		config.vision.useBatchKernel = mode.useBatchKernel;
+		config.vision.useSpecializedKernels = mode.useSpecializedKernels;
+		config.vision.verifyBatchKernel = false;
+	}
+}
+
+void VisionBenchmark::RestoreConfig()
+{
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+		m_simulation->GetAgentConfig((Species) i) = m_originalConfigs[i];
+}
+
+// Redraw every agent's retinas from its captured candidates.
+void VisionBenchmark::SeeAll()
+{
+	for (unsigned int i = 0; i < m_samples.size(); ++i)
+	{
+		const AgentSample& sample = m_samples[i];
+		sample.agent->SeeObjects(m_candidates.data() + sample.firstCandidate,
+			sample.numCandidates);
+	}
+}
+
+// Concatenate every agent's sight input values.
+void VisionBenchmark::ReadSightValues(std::vector<float>& outSightValues)
+{
+	outSightValues.resize(m_numSightValues);
+	for (unsigned int i = 0; i < m_samples.size(); ++i)
+	{
+		const AgentSample& sample = m_samples[i];
+		const float* sightInputs = sample.agent->GetBrain()->
+			GetNeuronActivations() + SIGHT_INPUTS_BEGIN;
+		for (unsigned int j = 0; j < sample.numSightValues; ++j)
+			outSightValues[sample.firstSightValue + j] = sightInputs[j];
+	}
+}
@@ -0,0 +1,85 @@
+#ifndef _VISION_BENCHMARK_H_
+#define _VISION_BENCHMARK_H_
+
+#include <simulation/Simulation.h>
+#include <string>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// VisionBenchmarkMode - A combination of vision settings to replay.
+//-----------------------------------------------------------------------------
+struct VisionBenchmarkMode
+{
+	const char*	name;
+	bool		useAnalyticProjection;
+	bool		useBatchKernel;
+	bool		useSpecializedKernels;
+};
+
+
+//-----------------------------------------------------------------------------
+// VisionBenchmark - Replays the vision work of every agent in a saved
+//                   simulation. Each agent's candidate objects are captured
+//                   once, then its retinas are redrawn from them many times
+//                   with each vision mode. The retinas drawn by each mode
+//                   are checked against the ones drawn with the simulation's
+//                   own settings: exactly when the mode uses the same
+//                   projection kernel, and within a small fraction of edge
+//                   pixels between the exact and approximate (batch)
+//                   analytic projections.
+//-----------------------------------------------------------------------------
+class VisionBenchmark
+{
+public:
+	VisionBenchmark();
+	~VisionBenchmark();
+
+	// Load the simulation to benchmark and capture its agents' candidates.
+	bool Load(const std::string& fileName);
+
+	// Replay every mode for the given number of iterations, printing the
+	// results. Sight values differing from the reference ones by more than
+	// the given tolerance are mismatches. Returns false if any mode has
+	// more mismatches than its projection allows.
+	bool Run(unsigned int numIterations, float tolerance);
+
+
+private:
+	// How a mode's projection kernel compares to the reference one.
+	enum ProjectionMatch
+	{
+		PROJECTION_EXACT = 0,	// The same kernel, so retinas match exactly.
+		PROJECTION_APPROXIMATE,	// Exact and approximate analytic kernels.
+		PROJECTION_DIFFERENT,	// Perspective and analytic projections.
+	};
+
+	struct AgentSample
+	{
+		Agent*			agent;
+		unsigned int	firstCandidate;
+		unsigned int	numCandidates;
+		unsigned int	firstSightValue;
+		unsigned int	numSightValues;
+	};
+
+	static ProjectionMatch CompareProjection(const VisionBenchmarkMode& mode,
+		const SpeciesConfig& config);
+	void CaptureCandidates();
+	void ApplyMode(const VisionBenchmarkMode& mode);
+	void RestoreConfig();
+	void SeeAll();
+	void ReadSightValues(std::vector<float>& outSightValues);
+
+
+private:
+	Simulation*						m_simulation;
+	SpeciesConfig					m_originalConfigs[SPECIES_COUNT];
+	std::vector<AgentSample>		m_samples;
+	std::vector<SimulationObject*>	m_candidates;
+	std::vector<float>				m_referenceSightValues;
+	unsigned int					m_numSightValues;
+};
+
+
+#endif // _VISION_BENCHMARK_H_
@@ -111,6 +111,15 @@ void InfoPanelCanvas::OnPaint(wxPaintEvent& e)
 	m_simInfoPanel.AddSeparator();
 	m_simInfoPanel.AddItem("avg move amount").SetValue(stats.combined.avgMoveAmount).InitBar(Color::GREEN, 0, 1);
 	m_simInfoPanel.AddItem("avg turn amount").SetValue(stats.combined.avgTurnAmount).InitBar(Color::CYAN, 0, 1);
+	m_simInfoPanel.AddSeparator();
+	const TickProfiler& profiler = simulation->GetProfiler();
+	m_simInfoPanel.AddItem("tick time", "ms").SetValue(profiler.GetTickTime());
+	m_simInfoPanel.AddItem("avg tick time", "ms").SetValue(profiler.GetAverageTickTime());
+	for (unsigned int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+	{
+		ProfilerCounter counter = (ProfilerCounter) i;
+		m_simInfoPanel.AddItem(TickProfiler::GetCounterName(counter)).SetValue(profiler.GetCount(counter));
+	}
 	m_simInfoPanel.Draw(m_graphics, bounds);
 
 	//-------------------------------------------------------------------------
@@ -119,7 +128,7 @@ void InfoPanelCanvas::OnPaint(wxPaintEvent& e)
 	Agent* agent = m_simulationWindow->GetSimulationManager()->GetSelectedAgent();
 	if (agent != nullptr)
 	{
-		Genome* genome = agent->GetGenome();
+		const Genome* genome = agent->GetGenome();
 
 		std::stringstream text;
 
@@ -164,6 +173,7 @@ void InfoPanelCanvas::OnPaint(wxPaintEvent& e)
 		m_agentInfoPanel.AddItem("resolution red").SetValue(agent->GetSightResolution(0)).InitBar(Color::RED, config.genes.minSightResolution, config.genes.maxSightResolution);
 		m_agentInfoPanel.AddItem("resolution green").SetValue(agent->GetSightResolution(1)).InitBar(Color::GREEN, config.genes.minSightResolution, config.genes.maxSightResolution);
 		m_agentInfoPanel.AddItem("resolution blue").SetValue(agent->GetSightResolution(2)).InitBar(colBlue, config.genes.minSightResolution, config.genes.maxSightResolution);
+		m_agentInfoPanel.AddItem("brain memory", "KB").SetValue(agent->GetBrain()->GetMemorySize() / 1024.0f).SetPrecision(1);
 
 		Vector2f panelPos(0, 0);
 		panelPos.y += m_simInfoPanel.GetSize().y;
@@ -3,6 +3,7 @@
 #include <utilities/Random.h>
 #include <simulation/ObjectManager.h>
 #include <simulation/Simulation.h>
+#include <utilities/Logging.h>
 #include <math/MathLib.h>
 #include <math/Vector2f.h>
 
@@ -19,13 +20,15 @@ Agent::Agent(Species species) :
 	m_genome(nullptr),
 	m_brain(nullptr),
 	m_energyUsage(0.0f),
-	m_species(species)
+	m_species(species),
+	m_sightDepths(nullptr),
+	m_drawVisionBatch(nullptr)
 {
 	m_inOrbit = 0.0f;
 }
 
 // Natural born constructor
-Agent::Agent(Genome* genome, float energy, Species species) :
+Agent::Agent(const Genome* genome, float energy, Species species) :
 	m_moveSpeed(0.0f),
 	m_turnSpeed(0.0f),
 	m_numEyes(2),
@@ -33,7 +36,9 @@ Agent::Agent(Genome* genome, float energy, Species species) :
 	m_energy(energy),
 	m_healthEnergy(energy),
 	m_brain(nullptr),
-	m_species(species)
+	m_species(species),
+	m_sightDepths(nullptr),
+	m_drawVisionBatch(nullptr)
 {
 	m_inOrbit = 0.0f;
 }
@@ -42,8 +47,11 @@ Agent::~Agent()
 {
 	delete m_brain;
 	m_brain = nullptr;
-	delete m_genome;
+	if (m_genome != nullptr)
+		m_genome->Release();
 	m_genome = nullptr;
+	delete [] m_sightDepths;
+	m_sightDepths = nullptr;
 }
 
 
@@ -73,19 +81,26 @@ void Agent::OnSpawn()
 	// This is a sign that this agent has no parents.
 	if (m_genome == nullptr)
 	{
-		m_genome = new Genome(config);
-		m_genome->Randomize(GetSimulation()->GetRandom());
+		Genome* genome = new Genome(config);
+		genome->Randomize(GetSimulation()->GetRandom());
+		m_genome = genome;
 		adamAndEve = true;
 	}
 
 	// May already be read() in
 	if (!m_isSerialized)
 	{
-		// Grow the brain from the genome.
+		// Grow the brain from the genome. Its pre-birth cycles are run
+		// later, together with those of the other agents born this tick.
 		m_brain = new Brain();
-		m_genome->GrowBrain(m_brain, GetSimulation()->GetRandom(), config);
-		m_brain->PreBirth(config.brain.numPrebirthCycles,
-			GetSimulation()->GetRandom());
+		m_genome->GrowBrain(m_brain, GetSimulation()->GetRandom(), config,
+			GetSimulation()->GetBrainCache(m_species));
+		m_objectManager->AddNewborn(this);
+	}
+	else if (config.brain.useBatchedUpdate && m_brain->IsDense())
+	{
+		// Let the species' brain batch take over the brain's weights.
+		m_objectManager->GetBrainBatch(m_species)->AddBrain(m_brain);
 	}
 
 	// Determine agent properties based on gene values.
@@ -162,9 +177,31 @@ void Agent::OnSpawn()
 		config.agent.radiusAtMaxStrength,
 		m_strength);
 
-	// Configure eyes.
-	m_eyes[0].Configure(m_fieldOfView, m_maxViewDistance, 3, resolutions);
-	m_eyes[1].Configure(m_fieldOfView, m_maxViewDistance, 3, resolutions);
+	// Configure eyes, angled outwards from the agent's forward direction.
+	float centerAngle = (m_angleBetweenEyes + m_fieldOfView) * 0.5f;
+	float eyeNearDistance = m_radius * 0.1f;
+	m_eyes[0].Configure(m_fieldOfView, m_maxViewDistance,
+		-centerAngle, eyeNearDistance, 3, resolutions);
+	m_eyes[1].Configure(m_fieldOfView, m_maxViewDistance,
+		centerAngle, eyeNearDistance, 3, resolutions);
+
+	// The retinas write into the brain's sight input neurons directly, with
+	// depths stored in a separate buffer of the same layout.
+	unsigned int numSightInputs = m_brain->GetNumInputNeurons() - NUM_NON_SIGHT_INPUTS;
+	delete [] m_sightDepths;
+	m_sightDepths = new float[numSightInputs];
+	for (unsigned int i = 0; i < numSightInputs; ++i)
+		m_sightDepths[i] = 1.0f;
+	BindRetinasToBrain();
+	m_isVisionValid = false;
+
+	// Select the vision kernel specialized for this species' retina layout.
+	m_drawVisionBatch = nullptr;
+	if (config.vision.useSpecializedKernels)
+	{
+		m_drawVisionBatch = RetinaKernels::Select(m_numEyes,
+			m_eyes[0].GetNumChannels(), config.genes.maxSightResolution);
+	}
 
 	if (adamAndEve)
 	{
@@ -178,65 +215,25 @@ void Agent::OnDestroy()
 	// Clean up my components.
 	delete m_brain;
 	m_brain = nullptr;
-	delete m_genome;
+	if (m_genome != nullptr)
+		m_genome->Release();
 	m_genome = nullptr;
+	delete [] m_sightDepths;
+	m_sightDepths = nullptr;
 }
 
 void Agent::Update()
 {
-	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
-
-	if (GetInOrbit())
-	{
-		// Fall
-		m_inOrbit -= 0.005f;
-		m_orientation.Rotate(m_orientation.GetUp(), 0.25f);
-		m_position.Normalize();
-		m_position *= GetSimulation()->GetWorld()->GetRadius() * m_inOrbit;
+	if (!UpdateSenses())
 		return;
-	}
-
-	UpdateVision();
-	UpdateBrain();
-
-	// Turn and move.
-	m_orientation.Rotate(m_orientation.GetUp(), m_turnSpeed);
-	m_objectManager->MoveObjectForward(this, m_moveSpeed);
-
-	// Update energy usage.
-	m_energyUsage = config.energy.energyCostExist +
-		(config.energy.energyCostMove * m_moveSpeed) +
-		(config.energy.energyCostTurn * m_turnSpeed) +
-		(config.energy.energyCostNeuron * m_brain->GetNumNeurons()) +
-		(config.energy.energyCostSynapse * m_brain->GetNumSynapses());
-	m_energy -= m_energyUsage;
-
-	m_age++;
-
-	if (m_mateWaitTime > 0)
-		m_mateWaitTime--;
-
-	// Kill agent after lifetime expiration.
-	if (m_age > m_lifeSpan)
-	{
-		Die();
-	}
-
-	// Kill agent if its energy is depleted.
-	if (m_energy <= 0.0f)
-	{
-		m_energy = 0.0f;
-		Die();
-	}
+	SetBrainInputs();
+	m_brain->Update();
+	UpdateActions();
 }
 
 void Agent::Read(std::ifstream& fileIn)
 {
-	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
-
 	m_isSerialized = true;
-	m_genome = new Genome(config);
-	m_brain = new Brain();
 
 	// Read basic info
 	int speciesIndex;
@@ -254,28 +251,23 @@ void Agent::Read(std::ifstream& fileIn)
 	fileIn.read((char*)&m_mateWaitTime, sizeof(int));
 	m_species = (Species) speciesIndex;
 
+	// The genome and brain follow the config of the species just read.
+	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
+	Genome* genome = new Genome(config);
+	m_genome = genome;
+	m_brain = new Brain();
+
 	// Read genome
-	fileIn.read((char*)m_genome->GetData(),
-		m_genome->GetSize() * sizeof(unsigned char));
+	fileIn.read((char*)genome->GetData(),
+		genome->GetSize() * sizeof(unsigned char));
 
 	// Read brain
-	fileIn.read((char*)&m_brain->m_numNeurons, sizeof(unsigned int));
-	fileIn.read((char*)&m_brain->m_numInputNeurons, sizeof(unsigned int));
-	fileIn.read((char*)&m_brain->m_numOutputNeurons, sizeof(unsigned int));
-	fileIn.read((char*)&m_brain->m_numSynapses, sizeof(unsigned int));
-	fileIn.read((char*)&m_brain->m_decayRate, sizeof(float));
-	fileIn.read((char*)&m_brain->m_maxWeight, sizeof(float));
-
-	// Allocate neuron and synapse arrays
-	m_brain->m_neurons = new Neuron[m_brain->m_numNeurons];
-	m_brain->m_currNeuronActivations = new float[m_brain->m_numNeurons];
-	m_brain->m_prevNeuronActivations = new float[m_brain->m_numNeurons];
-	m_brain->m_synapses = new Synapse[m_brain->m_numSynapses];
-
-	// Read neuron and synapse data
-	fileIn.read((char*)m_brain->m_neurons, m_brain->m_numNeurons * sizeof(Neuron));
-	fileIn.read((char*)m_brain->m_synapses, m_brain->m_numSynapses * sizeof(Synapse));
-	fileIn.read((char*)m_brain->m_currNeuronActivations, m_brain->m_numNeurons * sizeof(float));
+	m_brain->Read(fileIn);
+	m_brain->InitWeights(config.brain.useDenseWeights,
+		(WeightPrecision) config.brain.weightPrecision);
+	m_brain->SelectDenseKernel(config.brain.useSpecializedKernels);
+	m_brain->SetLearningInterval(config.brain.hebbianLearningInterval);
+	m_brain->SetSigmoidFunction((SigmoidFunction) config.brain.sigmoidFunction);
 }
 
 void Agent::Write(std::ofstream& fileOut)
@@ -283,7 +275,6 @@ void Agent::Write(std::ofstream& fileOut)
 	if (!m_isDestroyed)
 	{
 		int objType = GetObjectType();
-
 		int speciesIndex = (int) m_species;
 
 		// Write basic info
@@ -305,18 +296,7 @@ void Agent::Write(std::ofstream& fileOut)
 		fileOut.write((char*)m_genome->GetData(), m_genome->GetSize() * sizeof(unsigned char));
 
 		// Write brain
-		fileOut.write((char*)&m_brain->m_numNeurons, sizeof(unsigned int));
-		fileOut.write((char*)&m_brain->m_numInputNeurons, sizeof(unsigned int));
-		fileOut.write((char*)&m_brain->m_numOutputNeurons, sizeof(unsigned int));
-		fileOut.write((char*)&m_brain->m_numSynapses, sizeof(unsigned int));
-		fileOut.write((char*)&m_brain->m_decayRate, sizeof(float));
-		fileOut.write((char*)&m_brain->m_maxWeight, sizeof(float));
-		fileOut.write((char*)m_brain->m_neurons,
-			m_brain->m_numNeurons * sizeof(Neuron));
-		fileOut.write((char*)m_brain->m_synapses,
-			m_brain->m_numSynapses * sizeof(Synapse));
-		fileOut.write((char*)m_brain->m_currNeuronActivations,
-			m_brain->m_numNeurons * sizeof(float));
+		m_brain->Write(fileOut);
 	}
 }
 
@@ -325,29 +305,60 @@ void Agent::Write(std::ofstream& fileOut)
 // Agent methods
 //-----------------------------------------------------------------------------
 
+// Point the retinas at the sight input neurons of the brain's current
+// activation buffer. The sight inputs are ordered by channel, then eye, then
+// pixel, with room for the species' max sight resolution in each strip.
+void Agent::BindRetinasToBrain()
+{
+	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
+
+	unsigned int maxResolution = config.genes.maxSightResolution;
+	float* sightInputs = m_brain->GetNeuronActivations() + SIGHT_INPUTS_BEGIN;
+	for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+	{
+		m_eyes[eyeIndex].SetBuffers(
+			sightInputs + (eyeIndex * maxResolution),
+			m_sightDepths + (eyeIndex * maxResolution),
+			m_numEyes * maxResolution);
+	}
+}
+
+// Returns true if the retinas should be recomputed this tick. Otherwise,
+// the brain keeps seeing the retinas from the last refresh.
+bool Agent::IsVisionRefreshTick(const SpeciesConfig& config) const
+{
+	if (!m_isVisionValid || config.vision.updateInterval <= 1)
+		return true;
+
+	unsigned int tick = m_objectManager->GetSimulation()->GetAgeInTicks();
+	if (config.vision.staggerUpdates)
+		tick += (unsigned int) m_objectId;
+	return (tick % (unsigned int) config.vision.updateInterval == 0);
+}
+
 void Agent::UpdateVision()
 {
 	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
+	TickProfiler& profiler = GetSimulation()->GetProfiler();
 
-	// Update eye matrices.
-	float zNear = 0.01f;
-	float zFar = m_maxViewDistance;
-	float centerAngle = (m_angleBetweenEyes + m_fieldOfView) * 0.5f;
-	Matrix4f eyePerspective = Matrix4f::CreatePerspective(
-		m_eyes[0].GetFieldOfView(), 1.0f, m_radius * 0.1f, m_maxViewDistance);
-	Matrix4f leftEyeRotation = Matrix4f::CreateRotation(
-		Vector3f::UNITY, -centerAngle);
-	Matrix4f rightEyeRotation = Matrix4f::CreateRotation(
-		Vector3f::UNITY, centerAngle);
-	m_eyes[0].SetEyeToProjection(eyePerspective);
-	m_eyes[1].SetEyeToProjection(eyePerspective);
-	m_eyes[0].SetWorldToEye(leftEyeRotation * m_worldToObject);
-	m_eyes[1].SetWorldToEye(rightEyeRotation * m_worldToObject);
-
-	// Clear all sight values.
-	m_eyes[0].ClearSightValues();
-	m_eyes[1].ClearSightValues();
-	
+	// Between vision refreshes, only query the objects close enough to
+	// interact with.
+	bool refreshVision = IsVisionRefreshTick(config);
+	float queryRadius = m_maxViewDistance;
+	if (refreshVision)
+	{
+		profiler.Count(PROFILER_VISION_REFRESHES);
+		m_isVisionValid = true;
+	}
+	else
+	{
+		profiler.Count(PROFILER_VISION_REUSES);
+		queryRadius = Math::Max(m_radius, config.agent.minMatingDistance);
+	}
+
+	std::vector<SimulationObject*>& visionCandidates =
+		GetSimulation()->GetVisionCandidates();
+	visionCandidates.clear();
 	std::vector<Agent*> agentMateCollisions;
 	std::vector<Agent*> agentCollisions;
 
@@ -355,10 +366,9 @@ void Agent::UpdateVision()
 	bool canEatPlants = true;
 	bool canMate = (m_mateWaitTime == 0 && GetSimulation()->IsMatingSeason());
 
-	// Query the octtree for objects within vision range.
-	Sphere visionSphere(m_position, m_maxViewDistance);
-	m_objectManager->GetOctTree()->Query(visionSphere,
-		[&](SimulationObject* object)
+	// Interact with each object within vision range, and gather the ones
+	// which might be seen.
+	auto visitObject = [&](SimulationObject* object)
 	{
 		if (object != this && !object->GetInOrbit())
 		{
@@ -390,13 +400,35 @@ void Agent::UpdateVision()
 				agentCollisions.push_back((Agent*) object);
 			}
 
-			// Attempt to see the object.
-			if (object->IsVisible())
-			{
-				SeeObject(object);
-			}
+			if (refreshVision && object->IsVisible())
+				visionCandidates.push_back(object);
 		}
-	});
+	};
+
+	// Gather the objects within vision range, either from the cell lists
+	// built for this tick or by querying the octtree.
+	Sphere visionSphere(m_position, queryRadius);
+	CellGrid* cellGrid = m_objectManager->GetCellGrid();
+	if (config.vision.useCellLists && cellGrid->IsBuilt())
+	{
+		cellGrid->Query(visionSphere, visitObject);
+		profiler.Count(PROFILER_CELLS, cellGrid->GetQueryCellCount());
+		profiler.Count(PROFILER_CELL_CANDIDATES, cellGrid->GetQueryObjectCount());
+	}
+	else
+	{
+		OctTree* octTree = m_objectManager->GetOctTree();
+		octTree->Query(visionSphere, visitObject);
+		profiler.Count(PROFILER_OCTTREE_NODES, octTree->GetQueryNodeCount());
+		profiler.Count(PROFILER_OCTTREE_CANDIDATES, octTree->GetQueryObjectCount());
+	}
+
+	// Redraw the retinas, or keep seeing the previous ones. Both eyes share
+	// one buffer laid out in brain input order.
+	if (refreshVision)
+		SeeObjects(visionCandidates.data(), (unsigned int) visionCandidates.size());
+	else
+		BindRetinasToBrain();
 
 	for (unsigned int i = 0; i < agentCollisions.size(); ++i)
 	{
@@ -595,7 +627,317 @@ void Agent::Mate(Agent* mate)
 	}
 }
 
-void Agent::SeeObject(SimulationObject* object)
+// Redraw the retinas from the given objects, which are all visible and
+// within vision range. The objects are drawn in the given order.
+void Agent::SeeObjects(SimulationObject* const* objects, unsigned int numObjects)
+{
+	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
+	TickProfiler& profiler = GetSimulation()->GetProfiler();
+
+	// Update the world-to-eye matrices for the reference perspective
+	// projection. The analytic projection works directly in agent-space.
+	bool useAnalyticProjection = config.vision.useAnalyticProjection;
+	bool useBatchKernel = useAnalyticProjection && config.vision.useBatchKernel;
+	bool useSpecializedKernel = useBatchKernel &&
+		config.vision.useSpecializedKernels && m_drawVisionBatch != nullptr;
+	VisionBatch& visionBatch = GetSimulation()->GetVisionBatch();
+	visionBatch.Clear();
+	if (!useAnalyticProjection)
+	{
+		m_eyes[0].UpdateWorldToEye(m_worldToObject);
+		m_eyes[1].UpdateWorldToEye(m_worldToObject);
+	}
+
+	// Clear all sight values. Both eyes share one buffer laid out in brain
+	// input order, so this also clears the unused sight inputs. Specialized
+	// kernels overwrite every sight input themselves.
+	BindRetinasToBrain();
+	if (!useSpecializedKernel)
+	{
+		float* sightInputs = m_brain->GetNeuronActivations() + SIGHT_INPUTS_BEGIN;
+		unsigned int numSightInputs = m_brain->GetNumInputNeurons() - NUM_NON_SIGHT_INPUTS;
+		for (unsigned int i = 0; i < numSightInputs; ++i)
+		{
+			sightInputs[i] = 0.0f; // Clear sight value to 0 (black).
+			m_sightDepths[i] = 1.0f; // Clear depth to max depth.
+		}
+	}
+
+	// Setup the early rejects for objects behind the agent's eyes or below
+	// its horizon. The eyes are at the top of the agent's body.
+	VisionCuller culler;
+	float coneHalfAngle = 0.0f;
+	for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+	{
+		coneHalfAngle = Math::Max(coneHalfAngle, (m_fieldOfView * 0.5f) +
+			Math::Abs(m_eyes[eyeIndex].GetCenterAngle()));
+	}
+	culler.Setup(m_worldToObject, coneHalfAngle,
+		m_position.Length() + m_radius,
+		GetSimulation()->GetWorld()->GetRadius(),
+		config.vision.cullBehind, config.vision.cullBeyondHorizon);
+
+	// Attempt to see each object, unless it can be cheaply rejected.
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		SimulationObject* object = objects[i];
+		float dist = m_position.DistTo(object->GetPosition());
+		float objectRadius = object->GetRadius();
+		profiler.Count(PROFILER_VISION_CANDIDATES);
+
+		if (culler.IsOutsideCone(object->GetPosition(), objectRadius, dist))
+			profiler.Count(PROFILER_VISION_CULLED_BEHIND);
+		else if (culler.IsBeyondHorizon(object->GetPosition(), objectRadius, dist))
+			profiler.Count(PROFILER_VISION_CULLED_HORIZON);
+		else if (useBatchKernel)
+			visionBatch.AddObject(object->GetPosition(),
+				objectRadius, object->GetColor());
+		else if (useAnalyticProjection)
+			SeeObjectAnalytic(object);
+		else
+			SeeObjectPerspective(object);
+	}
+
+	// See all the gathered objects at once.
+	if (useBatchKernel)
+		SeeObjectBatch(visionBatch, config);
+}
+
+// Rasterize a batch of gathered objects onto the retinas. This matches
+// SeeObjectAnalytic(), but projects several objects at a time.
+void Agent::SeeObjectBatch(VisionBatch& visionBatch, const SpeciesConfig& config)
+{
+	VisionBatchParams params;
+	params.worldToAgent = m_worldToObject;
+	params.agentPosition = m_position;
+	params.viewDistance = m_maxViewDistance;
+	params.numEyes = m_numEyes;
+	for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+	{
+		params.eyeCenterAngle[eyeIndex] = m_eyes[eyeIndex].GetCenterAngle();
+		params.eyeInvFieldOfView[eyeIndex] = m_eyes[eyeIndex].GetInvFieldOfView();
+	}
+
+	// Compute the span and depth of every object on each eye. When
+	// verifying, the SIMD lanes must match the scalar kernel bit for bit,
+	// and both must be close to the exact analytic projection.
+	if (config.vision.verifyBatchKernel)
+	{
+		unsigned int numLaneMismatches = visionBatch.ProjectAndVerify(params);
+		if (numLaneMismatches > 0)
+		{
+			SEAL_LOG_MSG("%s vision kernel mismatch: %u of %u objects differ from the scalar kernel",
+				VisionBatch::GetInstructionSetName(), numLaneMismatches,
+				visionBatch.GetNumObjects());
+		}
+		unsigned int numMismatches = VerifyVisionBatch(visionBatch);
+		if (numMismatches > 0)
+		{
+			SEAL_LOG_MSG("%s vision kernel mismatch: %u of %u objects differ from the analytic projection",
+				VisionBatch::GetInstructionSetName(), numMismatches,
+				visionBatch.GetNumObjects());
+		}
+	}
+	else
+	{
+		visionBatch.Project(params);
+	}
+
+	// Draw with the kernel specialized for this agent's retina layout.
+	if (config.vision.useSpecializedKernels && m_drawVisionBatch != nullptr)
+	{
+		RetinaKernelParams kernelParams;
+		kernelParams.numEyes = m_numEyes;
+		for (unsigned int channel = 0; channel < m_eyes[0].GetNumChannels(); ++channel)
+			kernelParams.resolutions[channel] = m_eyes[0].GetResolution(channel);
+		kernelParams.sightInputStride = config.genes.maxSightResolution;
+		kernelParams.sightInputs = m_brain->GetNeuronActivations() + SIGHT_INPUTS_BEGIN;
+		kernelParams.frontToBack = config.vision.frontToBack;
+		m_drawVisionBatch(visionBatch, kernelParams);
+		return;
+	}
+
+	// Draw the visible objects onto the retinas nearest first, skipping
+	// objects which are hidden behind already drawn ones, until every
+	// pixel of every eye is covered.
+	if (config.vision.frontToBack &&
+		config.genes.maxSightResolution <= (int) RetinaCoverage::MAX_RESOLUTION)
+	{
+		RetinaCoverage coverage[2];
+		unsigned int numSaturatedEyes = 0;
+		for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+			coverage[eyeIndex].Reset(m_eyes[eyeIndex]);
+
+		visionBatch.SortVisibleByDepth(m_numEyes);
+
+		for (unsigned int order = 0; order < visionBatch.GetNumSorted() &&
+			numSaturatedEyes < m_numEyes; ++order)
+		{
+			unsigned int i = visionBatch.GetSortedIndex(order);
+			float depth = visionBatch.GetDepth(i);
+			Vector3f color = visionBatch.GetColor(i);
+
+			for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+			{
+				float t1 = visionBatch.GetSpanBegin(eyeIndex, i);
+				float t2 = visionBatch.GetSpanEnd(eyeIndex, i);
+
+				// Clip it if it is outside the field of view.
+				if (coverage[eyeIndex].IsSaturated() || t2 < 0.0f || t1 >= 1.0f)
+					continue;
+
+				coverage[eyeIndex].DrawSpan(m_eyes[eyeIndex], color, t1, t2, depth);
+				if (coverage[eyeIndex].IsSaturated())
+					numSaturatedEyes++;
+			}
+		}
+		return;
+	}
+
+	// Draw the visible objects onto the retinas with depth testing.
+	for (unsigned int i = 0; i < visionBatch.GetNumObjects(); ++i)
+	{
+		float depth = visionBatch.GetDepth(i);
+		if (depth > 1.0f)
+			continue;
+
+		Vector3f color = visionBatch.GetColor(i);
+		for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+		{
+			float t1 = visionBatch.GetSpanBegin(eyeIndex, i);
+			float t2 = visionBatch.GetSpanEnd(eyeIndex, i);
+
+			// Clip it if it is outside the field of view.
+			if (t2 < 0.0f || t1 >= 1.0f)
+				continue;
+
+			DrawObjectOnRetina(m_eyes[eyeIndex], color, t1, t2, depth);
+		}
+	}
+}
+
+// Count the objects in a projected batch whose depth or span on any eye
+// differs from the analytic projection's by more than the tolerance. The
+// batch kernel approximates the arc tangent and arc sine to within about
+// 1e-7 radians, and its spans stay within about 2e-5 of the field of view
+// of the analytic ones. The tolerance is 1e-4 of the field of view for
+// spans (well under a pixel at any resolution), and 1e-5 for depths, which
+// are fractions of the view distance.
+unsigned int Agent::VerifyVisionBatch(const VisionBatch& visionBatch) const
+{
+	const float SPAN_TOLERANCE = 1e-4f;
+	const float DEPTH_TOLERANCE = 1e-5f;
+
+	unsigned int numMismatches = 0;
+	for (unsigned int i = 0; i < visionBatch.GetNumObjects(); ++i)
+	{
+		float depth;
+		float spanBegin[2];
+		float spanEnd[2];
+		bool isInView = ProjectObjectAnalytic(visionBatch.GetPosition(i),
+			visionBatch.GetRadius(i), depth, spanBegin, spanEnd);
+
+		// Objects beyond the view distance only need to be marked so.
+		bool isMatch = (isInView == (visionBatch.GetDepth(i) <= 1.0f));
+		if (isMatch && isInView)
+		{
+			isMatch = (Math::Abs(visionBatch.GetDepth(i) - depth) <= DEPTH_TOLERANCE);
+			for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+			{
+				isMatch = isMatch && (Math::Abs(visionBatch.GetSpanBegin(
+					eyeIndex, i) - spanBegin[eyeIndex]) <= SPAN_TOLERANCE);
+				isMatch = isMatch && (Math::Abs(visionBatch.GetSpanEnd(
+					eyeIndex, i) - spanEnd[eyeIndex]) <= SPAN_TOLERANCE);
+			}
+		}
+		if (!isMatch)
+			numMismatches++;
+	}
+	return numMismatches;
+}
+
+// Rasterize an object onto the retinas using its angle and angular radius
+// in agent-space. Retina pixels are spaced evenly by angle.
+void Agent::SeeObjectAnalytic(SimulationObject* object)
+{
+	float depth;
+	float spanBegin[2];
+	float spanEnd[2];
+	if (!ProjectObjectAnalytic(object->GetPosition(),
+		object->GetRadius(), depth, spanBegin, spanEnd))
+		return;
+
+	// Update vision for each eye.
+	for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+	{
+		float t1 = spanBegin[eyeIndex];
+		float t2 = spanEnd[eyeIndex];
+
+		// Clip it if it is outside the field of view.
+		if (t2 < 0.0f || t1 >= 1.0f)
+			continue;
+
+		DrawObjectOnRetina(m_eyes[eyeIndex], object->GetColor(), t1, t2, depth);
+	}
+}
+
+// Compute an object's depth and its span on each eye from its angle and
+// angular radius in agent-space. Returns false if the object is too far
+// away to be seen.
+bool Agent::ProjectObjectAnalytic(const Vector3f& position, float objectRadius,
+	float& outDepth, float* outSpanBegin, float* outSpanEnd) const
+{
+	float distSqr = position.DistToSqr(m_position);
+
+	// Discard objects that are too far away.
+	if (distSqr > m_maxViewDistance * m_maxViewDistance)
+		return false;
+
+	float angle = 0.0f;
+	float angularRadius = Math::PI;
+	float depth = 0.0f;
+
+	// Check if we are inside the object. If so, then the object's
+	// color should fill the entirety of our vision strip.
+	if (distSqr > objectRadius * objectRadius)
+	{
+		// Transform the object into agent-space, where the agent looks down
+		// the negative z-axis and the positive x-axis is to its right.
+		Vector3f posInAgent = m_worldToObject.Multiply4x3(position);
+
+		// The retinas are horizontal strips, so measure the object's angle
+		// and angular radius within the agent's xz-plane.
+		float planarDistSqr = (posInAgent.x * posInAgent.x) +
+			(posInAgent.z * posInAgent.z);
+		angle = Math::ATan2(posInAgent.x, -posInAgent.z);
+		if (planarDistSqr > objectRadius * objectRadius)
+			angularRadius = Math::ASin(objectRadius / Math::Sqrt(planarDistSqr));
+		depth = Math::Sqrt(distSqr) / m_maxViewDistance;
+	}
+
+	// Compute the object's span on each eye.
+	outDepth = depth;
+	for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
+	{
+		const Retina& eye = m_eyes[eyeIndex];
+
+		// Get the object's angle relative to the eye's center.
+		float angleInEye = angle - eye.GetCenterAngle();
+		if (angleInEye > Math::PI)
+			angleInEye -= Math::TWO_PI;
+		else if (angleInEye < -Math::PI)
+			angleInEye += Math::TWO_PI;
+
+		float invFieldOfView = eye.GetInvFieldOfView();
+		outSpanBegin[eyeIndex] = ((angleInEye - angularRadius) * invFieldOfView) + 0.5f;
+		outSpanEnd[eyeIndex] = ((angleInEye + angularRadius) * invFieldOfView) + 0.5f;
+	}
+	return true;
+}
+
+// Rasterize an object onto the retinas using each eye's perspective
+// projection. This is kept as a reference for the analytic projection.
+void Agent::SeeObjectPerspective(SimulationObject* object)
 {
 	float distSqr = object->GetPosition().DistToSqr(m_position);
 
@@ -619,9 +961,9 @@ void Agent::SeeObject(SimulationObject* object)
 		if (!isInsideMe)
 		{
 			// Get the position of the object in the eye's perspective projection.
-			Matrix4f worldToEye = eye.GetWorldToEye();
+			const Matrix4f& worldToEye = eye.GetWorldToEye();
 			Vector3f posInEye = worldToEye.ApplyTransform(object->GetPosition());
-			Matrix4f projection = eye.GetEyeToProjection();
+			const Matrix4f& projection = eye.GetEyeToProjection();
 			Vector3f posInProj1 = projection.ApplyTransform(posInEye -
 				Vector3f(object->GetRadius(), 0, 0));
 			Vector3f posInProj2 = projection.ApplyTransform(posInEye +
@@ -638,34 +980,103 @@ void Agent::SeeObject(SimulationObject* object)
 			depth = posInProj1.z;
 		}
 
-		// Update the individual channels based on the object's position and color.
-		for (unsigned int channel = 0; channel < eye.GetNumChannels(); channel++)
-		{
-			int index1 = (int) (t1 * eye.GetResolution(channel));
-			int index2 = (int) (t2 * eye.GetResolution(channel));
-			index1 = Math::Clamp(index1, 0, (int) eye.GetResolution(channel) - 1);
-			index2 = Math::Clamp(index2, 0, (int) eye.GetResolution(channel) - 1);
+		DrawObjectOnRetina(eye, object->GetColor(), t1, t2, depth);
+	}
+}
 
-			for (int index = index1; index <= index2; index++)
-			{
-				eye.SetSightValue(channel, (unsigned int) index,
-					object->GetColor()[channel], depth);
-			}
+// Fill the span [t1, t2] of an eye's vision strip with an object's color.
+void Agent::DrawObjectOnRetina(Retina& eye, const Vector3f& color,
+	float t1, float t2, float depth)
+{
+	// Update the individual channels based on the object's position and color.
+	for (unsigned int channel = 0; channel < eye.GetNumChannels(); channel++)
+	{
+		int index1, index2;
+		eye.GetPixelRange(channel, t1, t2, index1, index2);
+
+		for (int index = index1; index <= index2; index++)
+		{
+			eye.SetSightValue(channel, (unsigned int) index,
+				color[channel], depth);
 		}
 	}
 }
 
-void Agent::UpdateBrain()
+// Get a seed for one of the agent's streams of random numbers, which only
+// depends on the simulation's seed, the agent's object ID, and the stream.
+unsigned long Agent::GetRandomSeed(AgentRandomStream stream, unsigned long index) const
+{
+	unsigned long seed = m_objectManager->GetSimulation()->GetOriginalSeed();
+	seed = RNG::MixSeed(seed, (unsigned long) m_objectId);
+	seed = RNG::MixSeed(seed, (unsigned long) stream);
+	return RNG::MixSeed(seed, index);
+}
+
+bool Agent::UpdateSenses()
+{
+	if (GetInOrbit())
+	{
+		// Fall
+		m_inOrbit -= 0.005f;
+		m_orientation.Rotate(m_orientation.GetUp(), 0.25f);
+		m_position.Normalize();
+		m_position *= GetSimulation()->GetWorld()->GetRadius() * m_inOrbit;
+		return false;
+	}
+
+	UpdateVision();
+	return true;
+}
+
+void Agent::UpdateActions()
 {
 	const SpeciesConfig& config = GetSimulation()->GetAgentConfig(m_species);
-	RNG& random = GetSimulation()->GetRandom();
 
-	//-------------------------------------------------------------------------
-	// Set the input nerve activations.
+	ReadBrainOutputs();
+
+	// Turn and move.
+	m_orientation.Rotate(m_orientation.GetUp(), m_turnSpeed);
+	m_objectManager->MoveObjectForward(this, m_moveSpeed);
+
+	// Update energy usage.
+	m_energyUsage = config.energy.energyCostExist +
+		(config.energy.energyCostMove * m_moveSpeed) +
+		(config.energy.energyCostTurn * m_turnSpeed) +
+		(config.energy.energyCostNeuron * m_brain->GetNumConnectedNeurons()) +
+		(config.energy.energyCostSynapse * m_brain->GetNumSynapses());
+	m_energy -= m_energyUsage;
+
+	m_age++;
+
+	if (m_mateWaitTime > 0)
+		m_mateWaitTime--;
+
+	// Kill agent after lifetime expiration.
+	if (m_age > m_lifeSpan)
+	{
+		Die();
+	}
+
+	// Kill agent if its energy is depleted.
+	if (m_energy <= 0.0f)
+	{
+		m_energy = 0.0f;
+		Die();
+	}
+}
+
+// This only changes the agent's own brain, so the brains of different
+// agents may be given their inputs on different threads.
+void Agent::SetBrainInputs()
+{
+	// The random input comes from the agent's own stream for this tick,
+	// rather than the simulation's, so it doesn't depend on the order in
+	// which agents are updated.
+	RNG random(GetRandomSeed(RANDOM_STREAM_BRAIN_INPUTS,
+		GetSimulation()->GetAgeInTicks()));
 
-	// Initially set all input activations to zero.
-	for (unsigned int i = 0; i < m_brain->GetNumInputNeurons(); ++i)
-		m_brain->SetNeuronActivation(i, 0.0f);
+	// Set the input nerve activations. The sight inputs were already
+	// written by UpdateVision().
 
 	// Could the agent reasonably mate? (magic numbered)
 	float canMateActivation = 0.0f;
@@ -678,31 +1089,11 @@ void Agent::UpdateBrain()
 	m_brain->SetNeuronActivation((unsigned int)CURRENT_ENERGY, m_energy / m_maxEnergy);
 	m_brain->SetNeuronActivation((unsigned int)RANDOM_ACTIVATION, random.NextFloat());
 	m_brain->SetNeuronActivation((unsigned int)CAN_MATE, canMateActivation);
-	
-	// Set vision neuron activations.
-	for (unsigned int eyeIndex = 0; eyeIndex < m_numEyes; ++eyeIndex)
-	{
-		Retina& eye = m_eyes[eyeIndex];
-		for (unsigned int channel = 0; channel < eye.GetNumChannels(); ++channel)
-		{
-			for (unsigned int i = 0; i < eye.GetResolution(channel); ++i)
-			{
-				unsigned int inputIndex = NUM_NON_SIGHT_INPUTS + (((channel * 2) + eyeIndex) *
-					config.genes.maxSightResolution) + i;
-				m_brain->SetNeuronActivation(inputIndex,
-					eye.GetSightValueAtIndex(channel, i));
-			}
-		}
-	}
-
-	//-------------------------------------------------------------------------
-	// Update the brain's neural network.
-
-	m_brain->Update();
+}
 
-	//-------------------------------------------------------------------------
+void Agent::ReadBrainOutputs()
+{
 	// Get the output nerve activations.
-
 	if (!m_manualOverride)
 	{
 		float moveAmount = m_brain->GetNeuronActivation(
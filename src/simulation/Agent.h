@@ -6,6 +6,8 @@
 #include "SimulationObject.h"
 #include <simulation/SimulationConfig.h>
 #include "Vision.h"
+#include "VisionBatch.h"
+#include "RetinaKernels.h"
 #include "Genome.h"
 #include "Brain.h"
 #include <math/MathLib.h>
@@ -13,6 +15,17 @@
 class Offshoot;
 
 
+//-----------------------------------------------------------------------------
+// AgentRandomStream - The agent's own streams of random numbers, which don't
+//                     depend on the order in which agents are updated.
+//-----------------------------------------------------------------------------
+enum AgentRandomStream
+{
+	RANDOM_STREAM_BRAIN_INPUTS = 0,	// The random input neuron, one per tick.
+	RANDOM_STREAM_PREBIRTH,			// The brain's pre-birth cycles.
+};
+
+
 //-----------------------------------------------------------------------------
 // Agent - A single being of the simulation with its own body and brain.
 //-----------------------------------------------------------------------------
@@ -27,8 +40,9 @@ public:
 	// Adam and Eve constructor
 	Agent(Species species = SPECIES_HERBIVORE);
 	
-	// Natural born constructor
-	Agent(Genome* genome, float energy, Species species);
+	// Natural born constructor. The agent takes over the caller's reference
+	// to the genome.
+	Agent(const Genome* genome, float energy, Species species);
 
 	~Agent();
 
@@ -44,9 +58,30 @@ public:
 	//-------------------------------------------------------------------------
 	// Agent methods
 
+	void BindRetinasToBrain();
+	bool IsVisionRefreshTick(const SpeciesConfig& config) const;
 	void UpdateVision();
-	void UpdateBrain();
-	void SeeObject(SimulationObject* object);
+	void SetBrainInputs();
+	void ReadBrainOutputs();
+
+	// Update() in stages, so the brains of all agents can be updated
+	// together in between, after SetBrainInputs(). UpdateSenses() returns
+	// false if the agent skips the rest of the tick (while falling from
+	// orbit).
+	bool UpdateSenses();
+	void UpdateActions();
+
+	unsigned long GetRandomSeed(AgentRandomStream stream, unsigned long index) const;
+
+	void SeeObjects(SimulationObject* const* objects, unsigned int numObjects);
+	void SeeObjectBatch(VisionBatch& visionBatch, const SpeciesConfig& config);
+	void SeeObjectAnalytic(SimulationObject* object);
+	bool ProjectObjectAnalytic(const Vector3f& position, float objectRadius,
+		float& outDepth, float* outSpanBegin, float* outSpanEnd) const;
+	unsigned int VerifyVisionBatch(const VisionBatch& visionBatch) const;
+	void SeeObjectPerspective(SimulationObject* object);
+	void DrawObjectOnRetina(Retina& eye, const Vector3f& color,
+		float t1, float t2, float depth);
 	void EatPlant(Offshoot* plant);
 	void Mate(Agent* other);
 	void Attack(Agent* other);
@@ -83,7 +118,7 @@ public:
 	inline Retina* GetEye(unsigned int index) { return &m_eyes[index]; }
 	inline const Retina* GetEye(unsigned int index) const { return &m_eyes[index]; }
 	inline Brain* GetBrain() { return m_brain; }
-	inline Genome* GetGenome() { return m_genome; }
+	inline const Genome* GetGenome() const { return m_genome; }
 	
 	//-------------------------------------------------------------------------
 	// Setters
@@ -102,7 +137,7 @@ public:
 
 private:
 
-	Genome*			m_genome;
+	const Genome*	m_genome;
 	Brain*			m_brain;
 
 	Species			m_species;
@@ -134,6 +169,9 @@ private:
 	// Vision
 	unsigned int	m_numEyes;
 	Retina			m_eyes[2]; // 0 = left eye, 1 = right eye.
+	float*			m_sightDepths; // Depth buffer for both eyes, in brain input order.
+	bool			m_isVisionValid; // False until the retinas are first computed.
+	RetinaKernels::DrawBatchFunc m_drawVisionBatch; // Specialized batch kernel, or null.
 
 	
 	// DEBUG: enable/disable manual override. This is for debug
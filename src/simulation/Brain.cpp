@@ -1,5 +1,9 @@
 #include "Brain.h"
+#include "BrainBatch.h"
+#include "BrainKernels.h"
+#include "DenseBrainKernels.h"
 #include <math/MathLib.h>
+#include <string.h>
 
 
 //-----------------------------------------------------------------------------
@@ -7,27 +11,47 @@
 //-----------------------------------------------------------------------------
 
 Brain::Brain() :
+	m_memoryBlock(nullptr),
+	m_memory(nullptr),
+	m_memorySize(0),
 	m_currNeuronActivations(nullptr),
 	m_prevNeuronActivations(nullptr),
 	m_neurons(nullptr),
 	m_numNeurons(0),
 	m_numInputNeurons(0),
 	m_numOutputNeurons(0),
+	m_numConnectedNeurons(0),
 	m_synapses(nullptr),
-	m_numSynapses(0)
+	m_numSynapses(0),
+	m_denseWeights(nullptr),
+	m_denseLearningRates(nullptr),
+	m_denseStride(0),
+	m_denseKernel(nullptr),
+	m_weightPrecision(WEIGHT_PRECISION_FLOAT32),
+	m_compactWeights(nullptr),
+	m_compactRowScales(nullptr),
+	m_compactLearningRateSigns(nullptr),
+	m_compactLearningRateMagnitude(0.0f),
+	m_compactRowWeights(nullptr),
+	m_compactRowLearningRates(nullptr),
+	m_sparseWeights(nullptr),
+	m_sparseLearningRates(nullptr),
+	m_sparseNeuronFrom(nullptr),
+	m_sparseInputs(nullptr),
+	m_hasLearningSynapses(false),
+	m_learningInterval(1),
+	m_learningTick(0),
+	m_batch(nullptr),
+	m_batchSlot(0),
+	m_sigmoidFunction(SIGMOID_EXACT)
 {
 }
 
 Brain::~Brain()
 {
-	delete m_currNeuronActivations;
-	m_currNeuronActivations = nullptr;
-	delete m_prevNeuronActivations;
-	m_prevNeuronActivations = nullptr;
-	delete m_neurons;
-	m_neurons = nullptr;
-	delete m_synapses;
-	m_synapses = nullptr;
+	if (m_batch != nullptr)
+		m_batch->RemoveBrain(this);
+	FreeMemory();
 }
 
 
@@ -49,32 +73,43 @@ void Brain::Initialize(const std::vector<Neuron>& neurons,
 void Brain::Initialize(unsigned int numNeurons,
 	unsigned int numSynapses, float initialActivation)
 {
-	delete m_currNeuronActivations;
-	m_currNeuronActivations = nullptr;
-	delete m_prevNeuronActivations;
-	m_prevNeuronActivations = nullptr;
-	delete m_neurons;
-	m_neurons = nullptr;
-	delete m_synapses;
-	m_synapses = nullptr;
+	if (m_batch != nullptr)
+		m_batch->RemoveBrain(this);
+	FreeMemory();
 
 	m_numNeurons = numNeurons;
 	m_numSynapses = numSynapses;
+	m_numConnectedNeurons = numNeurons;
 
-	// Allocate neuron and synapse arrays.
-	m_synapses = new Synapse[numSynapses];
-	m_neurons = new Neuron[numNeurons];
-	m_currNeuronActivations = new float[numNeurons];
-	m_prevNeuronActivations = new float[numNeurons];
+	// Allocate the activation, neuron and synapse arrays.
+	AllocateMemory(WEIGHTS_NONE);
+	unsigned int numPaddedNeurons = GetPaddedNeuronCount(numNeurons);
 	
 	// Setup the initial neuron activation values.
-	for (unsigned int i = 0; i < numNeurons; ++i)
+	for (unsigned int i = 0; i < numPaddedNeurons; ++i)
 	{
-		m_currNeuronActivations[i] = initialActivation;
-		m_prevNeuronActivations[i] = initialActivation;
+		float activation = (i < numNeurons ? initialActivation : 0.0f);
+		m_currNeuronActivations[i] = activation;
+		m_prevNeuronActivations[i] = activation;
 	}
 }
 
+void Brain::CopyTopology(const Brain& source)
+{
+	Initialize(source.m_numNeurons, source.m_numSynapses, 0.0f);
+	m_numInputNeurons = source.m_numInputNeurons;
+	m_numOutputNeurons = source.m_numOutputNeurons;
+	m_numConnectedNeurons = source.m_numConnectedNeurons;
+	m_maxWeight = source.m_maxWeight;
+	m_decayRate = source.m_decayRate;
+
+	unsigned int numPaddedNeurons = GetPaddedNeuronCount(m_numNeurons);
+	memcpy(m_currNeuronActivations, source.m_currNeuronActivations, numPaddedNeurons * sizeof(float));
+	memcpy(m_prevNeuronActivations, source.m_prevNeuronActivations, numPaddedNeurons * sizeof(float));
+	memcpy(m_neurons, source.m_neurons, m_numNeurons * sizeof(Neuron));
+	memcpy(m_synapses, source.m_synapses, m_numSynapses * sizeof(Synapse));
+}
+
 void Brain::ConfigNeuron(unsigned int neuronIndex, float bias,
 	unsigned int synapsesBegin, unsigned int synapsesEnd)
 {
@@ -94,6 +129,447 @@ void Brain::ConfigSynapse(unsigned int synapseIndex, float weight,
 	synapse.neuronTo = neuronTo;
 }
 
+void Brain::InitWeights(bool useDenseWeights, WeightPrecision weightPrecision)
+{
+	// Compact brains have no synapse list to build new weights from.
+	if (m_compactWeights != nullptr)
+		return;
+
+	if (m_batch != nullptr)
+		m_batch->RemoveBrain(this);
+	FreeWeights();
+
+	m_hasLearningSynapses = false;
+	for (unsigned int k = 0; k < m_numSynapses; ++k)
+		m_hasLearningSynapses = m_hasLearningSynapses || (m_synapses[k].learningRate != 0.0f);
+
+	// Learning synapses change by small steps every tick, which would be
+	// lost to rounding when 8-bit rows are requantized, so store learning
+	// brains with 16-bit weights instead.
+	if (weightPrecision == WEIGHT_PRECISION_INT8 && m_hasLearningSynapses)
+		weightPrecision = WEIGHT_PRECISION_FLOAT16;
+
+	float learningRateMagnitude;
+	if (useDenseWeights && IsDenseLayout())
+	{
+		if (weightPrecision != WEIGHT_PRECISION_FLOAT32 &&
+			GetLearningRateMagnitude(learningRateMagnitude))
+			InitCompactWeights(weightPrecision, learningRateMagnitude);
+		else
+			InitDenseWeights();
+	}
+	else
+	{
+		InitSparseWeights();
+	}
+}
+
+void Brain::SelectDenseKernel(bool useSpecializedKernels)
+{
+	m_denseKernel = nullptr;
+	if (useSpecializedKernels && m_denseWeights != nullptr)
+		m_denseKernel = DenseBrainKernels::Select(m_denseStride);
+}
+
+void Brain::Prune(const std::vector<bool>& isInputUsed)
+{
+	unsigned int i, k;
+
+	if (m_batch != nullptr)
+		m_batch->RemoveBrain(this);
+	SyncWeights();
+
+	// Find which synapses can carry a signal.
+	std::vector<bool> isSynapseLive(m_numSynapses);
+	for (k = 0; k < m_numSynapses; ++k)
+	{
+		const Synapse& synapse = m_synapses[k];
+		isSynapseLive[k] = (synapse.weight != 0.0f || synapse.learningRate != 0.0f) &&
+			synapse.neuronFrom != synapse.neuronTo &&
+			(synapse.neuronFrom >= m_numInputNeurons || isInputUsed[synapse.neuronFrom]);
+	}
+
+	// Walk backwards from the output neurons over the live synapses to find
+	// the neurons which have a path to an output.
+	std::vector<bool> isNeuronKept(m_numNeurons, false);
+	std::vector<unsigned int> neuronStack;
+	for (i = m_numInputNeurons; i < m_numInputNeurons + m_numOutputNeurons; ++i)
+	{
+		isNeuronKept[i] = true;
+		neuronStack.push_back(i);
+	}
+	while (!neuronStack.empty())
+	{
+		const Neuron& neuron = m_neurons[neuronStack.back()];
+		neuronStack.pop_back();
+		for (k = neuron.synapsesBegin; k < neuron.synapsesEnd; ++k)
+		{
+			unsigned int neuronFrom = m_synapses[k].neuronFrom;
+			if (isSynapseLive[k] && !isNeuronKept[neuronFrom])
+			{
+				isNeuronKept[neuronFrom] = true;
+				if (neuronFrom >= m_numInputNeurons)
+					neuronStack.push_back(neuronFrom);
+			}
+		}
+	}
+
+	// Compact the live synapses into the kept neurons' rows.
+	std::vector<Synapse> synapses;
+	for (i = m_numInputNeurons; i < m_numNeurons; ++i)
+	{
+		Neuron& neuron = m_neurons[i];
+		unsigned int synapsesBegin = synapses.size();
+		if (isNeuronKept[i])
+		{
+			for (k = neuron.synapsesBegin; k < neuron.synapsesEnd; ++k)
+			{
+				if (isSynapseLive[k])
+					synapses.push_back(m_synapses[k]);
+			}
+		}
+		neuron.synapsesBegin = synapsesBegin;
+		neuron.synapsesEnd = synapses.size();
+	}
+
+	m_numSynapses = synapses.size();
+	for (k = 0; k < m_numSynapses; ++k)
+		m_synapses[k] = synapses[k];
+
+	// The weight arrays must be rebuilt for the compacted synapses, so
+	// shrink the memory block to fit them until then.
+	FreeWeights();
+	AllocateMemory(WEIGHTS_NONE);
+	CountConnectedNeurons();
+}
+
+void Brain::Read(std::ifstream& fileIn)
+{
+	unsigned int numNeurons;
+	unsigned int numSynapses;
+	fileIn.read((char*) &numNeurons, sizeof(unsigned int));
+	fileIn.read((char*) &m_numInputNeurons, sizeof(unsigned int));
+	fileIn.read((char*) &m_numOutputNeurons, sizeof(unsigned int));
+	fileIn.read((char*) &numSynapses, sizeof(unsigned int));
+	fileIn.read((char*) &m_decayRate, sizeof(float));
+	fileIn.read((char*) &m_maxWeight, sizeof(float));
+
+	Initialize(numNeurons, numSynapses, 0.0f);
+	fileIn.read((char*) m_neurons, m_numNeurons * sizeof(Neuron));
+	fileIn.read((char*) m_synapses, m_numSynapses * sizeof(Synapse));
+	fileIn.read((char*) m_currNeuronActivations, m_numNeurons * sizeof(float));
+	CountConnectedNeurons();
+}
+
+void Brain::Write(std::ofstream& fileOut)
+{
+	SyncWeights();
+
+	fileOut.write((char*) &m_numNeurons, sizeof(unsigned int));
+	fileOut.write((char*) &m_numInputNeurons, sizeof(unsigned int));
+	fileOut.write((char*) &m_numOutputNeurons, sizeof(unsigned int));
+	fileOut.write((char*) &m_numSynapses, sizeof(unsigned int));
+	fileOut.write((char*) &m_decayRate, sizeof(float));
+	fileOut.write((char*) &m_maxWeight, sizeof(float));
+	fileOut.write((char*) m_neurons, m_numNeurons * sizeof(Neuron));
+	if (m_synapses != nullptr)
+	{
+		fileOut.write((char*) m_synapses, m_numSynapses * sizeof(Synapse));
+	}
+	else
+	{
+		for (unsigned int k = 0; k < m_numSynapses; ++k)
+		{
+			Synapse synapse = GetSynapse(k);
+			fileOut.write((char*) &synapse, sizeof(Synapse));
+		}
+	}
+	fileOut.write((char*) m_currNeuronActivations, m_numNeurons * sizeof(float));
+}
+
+// Check that the synapses are laid out as a dense matrix.
+bool Brain::IsDenseLayout() const
+{
+	unsigned int numRows = m_numNeurons - m_numInputNeurons;
+	if (m_numSynapses != numRows * m_numNeurons)
+		return false;
+	for (unsigned int row = 0; row < numRows; ++row)
+	{
+		const Neuron& neuron = m_neurons[m_numInputNeurons + row];
+		if (neuron.synapsesBegin != row * m_numNeurons ||
+			neuron.synapsesEnd != neuron.synapsesBegin + m_numNeurons)
+			return false;
+	}
+	for (unsigned int k = 0; k < m_numSynapses; ++k)
+	{
+		if (m_synapses[k].neuronFrom != k % m_numNeurons ||
+			m_synapses[k].neuronTo != (k / m_numNeurons) + m_numInputNeurons)
+			return false;
+	}
+	return true;
+}
+
+// Copy the weights and learning rates into the matrices, leaving the
+// padding as zero.
+void Brain::InitDenseWeights()
+{
+	unsigned int numRows = m_numNeurons - m_numInputNeurons;
+	AllocateMemory(WEIGHTS_DENSE);
+	for (unsigned int row = 0; row < numRows; ++row)
+	{
+		float* rowWeights = m_denseWeights + (row * m_denseStride);
+		float* rowLearningRates = m_denseLearningRates + (row * m_denseStride);
+		const Synapse* rowSynapses = m_synapses + (row * m_numNeurons);
+		for (unsigned int i = 0; i < m_denseStride; ++i)
+		{
+			rowWeights[i] = (i < m_numNeurons ? rowSynapses[i].weight : 0.0f);
+			rowLearningRates[i] = (i < m_numNeurons ? rowSynapses[i].learningRate : 0.0f);
+		}
+	}
+}
+
+void Brain::InitSparseWeights()
+{
+	AllocateMemory(WEIGHTS_SPARSE);
+	for (unsigned int k = 0; k < m_numSynapses; ++k)
+	{
+		m_sparseWeights[k] = m_synapses[k].weight;
+		m_sparseLearningRates[k] = m_synapses[k].learningRate;
+		m_sparseNeuronFrom[k] = m_synapses[k].neuronFrom;
+		m_sparseInputs[k] = 0.0f;
+	}
+}
+
+// Find the magnitude shared by all non-zero learning rates. Returns false
+// if they have different magnitudes.
+bool Brain::GetLearningRateMagnitude(float& outMagnitude) const
+{
+	outMagnitude = 0.0f;
+	for (unsigned int k = 0; k < m_numSynapses; ++k)
+	{
+		float magnitude = Math::Abs(m_synapses[k].learningRate);
+		if (magnitude == 0.0f)
+			continue;
+		if (outMagnitude == 0.0f)
+			outMagnitude = magnitude;
+		else if (magnitude != outMagnitude)
+			return false;
+	}
+	return true;
+}
+
+void Brain::InitCompactWeights(WeightPrecision weightPrecision, float learningRateMagnitude)
+{
+	unsigned int numRows = m_numNeurons - m_numInputNeurons;
+
+	// The synapse list is replaced, so keep it until the weights are encoded.
+	std::vector<Synapse> synapses(m_synapses, m_synapses + m_numSynapses);
+	AllocateMemory(WEIGHTS_COMPACT, weightPrecision);
+	m_compactLearningRateMagnitude = learningRateMagnitude;
+
+	for (unsigned int row = 0; row < numRows; ++row)
+	{
+		const Synapse* rowSynapses = synapses.data() + (row * m_numNeurons);
+		signed char* rowSigns = m_compactLearningRateSigns + (row * m_denseStride);
+		for (unsigned int i = 0; i < m_denseStride; ++i)
+		{
+			float learningRate = (i < m_numNeurons ? rowSynapses[i].learningRate : 0.0f);
+			m_compactRowWeights[i] = (i < m_numNeurons ? rowSynapses[i].weight : 0.0f);
+			rowSigns[i] = (learningRate > 0.0f ? 1 : (learningRate < 0.0f ? -1 : 0));
+		}
+		EncodeCompactWeights(row, m_compactRowWeights);
+	}
+}
+
+void Brain::DecodeCompactWeights(unsigned int row, float* outWeights) const
+{
+	unsigned int offset = row * m_denseStride;
+	if (m_weightPrecision == WEIGHT_PRECISION_FLOAT16)
+	{
+		DecodeHalfRow((const unsigned short*) m_compactWeights + offset,
+			m_denseStride, outWeights);
+	}
+	else
+	{
+		DecodeInt8Row((const signed char*) m_compactWeights + offset,
+			m_denseStride, m_compactRowScales[row], outWeights);
+	}
+}
+
+void Brain::DecodeCompactLearningRates(unsigned int row, float* outLearningRates) const
+{
+	DecodeInt8Row(m_compactLearningRateSigns + (row * m_denseStride),
+		m_denseStride, m_compactLearningRateMagnitude, outLearningRates);
+}
+
+void Brain::EncodeCompactWeights(unsigned int row, const float* weights)
+{
+	unsigned int offset = row * m_denseStride;
+	if (m_weightPrecision == WEIGHT_PRECISION_FLOAT16)
+	{
+		EncodeHalfRow(weights, m_denseStride,
+			(unsigned short*) m_compactWeights + offset);
+	}
+	else
+	{
+		// Scale the row so its largest weight maps to 127.
+		typedef BrainLanes L;
+		L::Type maxWeights = L::Set(0.0f);
+		for (unsigned int i = 0; i < m_denseStride; i += L::WIDTH)
+			maxWeights = L::Max(maxWeights, L::Abs(L::Load(weights + i)));
+		float maxWeight = 0.0f;
+		float lanes[L::WIDTH];
+		L::Store(lanes, maxWeights);
+		for (unsigned int i = 0; i < L::WIDTH; ++i)
+			maxWeight = Math::Max(maxWeight, lanes[i]);
+
+		m_compactRowScales[row] = maxWeight / 127.0f;
+		EncodeInt8Row(weights, m_denseStride,
+			(maxWeight > 0.0f ? 127.0f / maxWeight : 0.0f),
+			(signed char*) m_compactWeights + offset);
+	}
+}
+
+// Forget the weight arrays. Their memory stays in the memory block until
+// it is next allocated.
+void Brain::FreeWeights()
+{
+	m_denseWeights = nullptr;
+	m_denseLearningRates = nullptr;
+	m_denseStride = 0;
+	m_denseKernel = nullptr;
+	m_sparseWeights = nullptr;
+	m_sparseLearningRates = nullptr;
+	m_sparseNeuronFrom = nullptr;
+	m_sparseInputs = nullptr;
+	m_weightPrecision = WEIGHT_PRECISION_FLOAT32;
+	m_compactWeights = nullptr;
+	m_compactRowScales = nullptr;
+	m_compactLearningRateSigns = nullptr;
+	m_compactLearningRateMagnitude = 0.0f;
+	m_compactRowWeights = nullptr;
+	m_compactRowLearningRates = nullptr;
+}
+
+void Brain::AllocateMemory(WeightLayout weightLayout, WeightPrecision weightPrecision)
+{
+	unsigned int numPaddedNeurons = GetPaddedNeuronCount(m_numNeurons);
+	unsigned int numRows = m_numNeurons - m_numInputNeurons;
+	unsigned int denseStride = numPaddedNeurons;
+	bool isCompact = (weightLayout == WEIGHTS_COMPACT);
+
+	// Find the size of each array.
+	unsigned int activationsSize = AlignMemorySize(numPaddedNeurons * sizeof(float));
+	unsigned int weightsSize = 0;
+	unsigned int numWeightArrays = 0;
+	if (weightLayout == WEIGHTS_DENSE)
+	{
+		weightsSize = AlignMemorySize(numRows * denseStride * sizeof(float));
+		numWeightArrays = 2;
+	}
+	else if (weightLayout == WEIGHTS_SPARSE)
+	{
+		weightsSize = AlignMemorySize(m_numSynapses * sizeof(float));
+		numWeightArrays = 4;
+	}
+	unsigned int compactWeightsSize = 0;
+	unsigned int compactRowScalesSize = 0;
+	unsigned int compactSignsSize = 0;
+	unsigned int compactRowSize = 0;
+	if (isCompact)
+	{
+		unsigned int bytesPerWeight = (weightPrecision == WEIGHT_PRECISION_FLOAT16 ? 2 : 1);
+		compactWeightsSize = AlignMemorySize(numRows * denseStride * bytesPerWeight);
+		compactRowScalesSize = AlignMemorySize(numRows * sizeof(float));
+		compactSignsSize = AlignMemorySize(numRows * denseStride);
+		compactRowSize = AlignMemorySize(denseStride * sizeof(float));
+	}
+	unsigned int neuronsSize = AlignMemorySize(m_numNeurons * sizeof(Neuron));
+	unsigned int synapsesSize = (isCompact ? 0 :
+		AlignMemorySize(m_numSynapses * sizeof(Synapse)));
+	unsigned int memorySize = (activationsSize * 2) +
+		(weightsSize * numWeightArrays) + compactWeightsSize +
+		compactRowScalesSize + compactSignsSize + (compactRowSize * 2) +
+		neuronsSize + synapsesSize;
+
+	// Allocate the block, and align its start.
+	unsigned char* memoryBlock = new unsigned char[memorySize + MEMORY_ALIGNMENT - 1];
+	unsigned char* memory = memoryBlock + ((MEMORY_ALIGNMENT -
+		((size_t) memoryBlock % MEMORY_ALIGNMENT)) % MEMORY_ALIGNMENT);
+
+	// Lay out the arrays.
+	unsigned char* next = memory;
+	float* currNeuronActivations = (float*) next;
+	next += activationsSize;
+	float* prevNeuronActivations = (float*) next;
+	next += activationsSize;
+	FreeWeights();
+	if (weightLayout == WEIGHTS_DENSE)
+	{
+		m_denseStride = denseStride;
+		m_denseWeights = (float*) next;
+		m_denseLearningRates = (float*) (next + weightsSize);
+	}
+	else if (weightLayout == WEIGHTS_SPARSE)
+	{
+		m_sparseWeights = (float*) next;
+		m_sparseLearningRates = (float*) (next + weightsSize);
+		m_sparseNeuronFrom = (unsigned int*) (next + (weightsSize * 2));
+		m_sparseInputs = (float*) (next + (weightsSize * 3));
+	}
+	next += weightsSize * numWeightArrays;
+	if (isCompact)
+	{
+		m_denseStride = denseStride;
+		m_weightPrecision = weightPrecision;
+		m_compactWeights = next;
+		next += compactWeightsSize;
+		m_compactRowScales = (float*) next;
+		next += compactRowScalesSize;
+		m_compactLearningRateSigns = (signed char*) next;
+		next += compactSignsSize;
+		m_compactRowWeights = (float*) next;
+		next += compactRowSize;
+		m_compactRowLearningRates = (float*) next;
+		next += compactRowSize;
+	}
+	Neuron* neurons = (Neuron*) next;
+	next += neuronsSize;
+	Synapse* synapses = (isCompact ? nullptr : (Synapse*) next);
+
+	// Move over the arrays from the previous block.
+	if (m_memoryBlock != nullptr)
+	{
+		memcpy(currNeuronActivations, m_currNeuronActivations, numPaddedNeurons * sizeof(float));
+		memcpy(prevNeuronActivations, m_prevNeuronActivations, numPaddedNeurons * sizeof(float));
+		memcpy(neurons, m_neurons, m_numNeurons * sizeof(Neuron));
+		if (synapses != nullptr && m_synapses != nullptr)
+			memcpy(synapses, m_synapses, m_numSynapses * sizeof(Synapse));
+		delete [] m_memoryBlock;
+	}
+
+	m_memoryBlock = memoryBlock;
+	m_memory = memory;
+	m_memorySize = memorySize;
+	m_currNeuronActivations = currNeuronActivations;
+	m_prevNeuronActivations = prevNeuronActivations;
+	m_neurons = neurons;
+	m_synapses = synapses;
+}
+
+void Brain::FreeMemory()
+{
+	FreeWeights();
+	delete [] m_memoryBlock;
+	m_memoryBlock = nullptr;
+	m_memory = nullptr;
+	m_memorySize = 0;
+	m_currNeuronActivations = nullptr;
+	m_prevNeuronActivations = nullptr;
+	m_neurons = nullptr;
+	m_synapses = nullptr;
+}
+
 
 //-----------------------------------------------------------------------------
 // Simulation
@@ -104,30 +580,139 @@ void Brain::PreBirth(unsigned int numCycles, RNG& random)
 	for (unsigned int i = 0; i < numCycles; ++i)
 	{
 		// 1. Randomize input neuron activations.
-		for (unsigned int k = 0; k < m_numInputNeurons; ++k)
-			m_currNeuronActivations[k] = random.NextFloat();
+		RandomizeInputs(random);
 
 		// 2. Update the entire network.
 		Update();
 	}
 }
 
-void Brain::Update()
+void Brain::RandomizeInputs(RNG& random)
 {
-	unsigned int i, k;
+	for (unsigned int k = 0; k < m_numInputNeurons; ++k)
+		m_currNeuronActivations[k] = random.NextFloat();
+}
 
-	int firstOutputNeuron = m_numInputNeurons;
-	float sigmoidSlope = 1.0f;
+void Brain::Update()
+{
+	// A batched brain's weights live in its batch, so let the batch update
+	// it (along with any other brains submitted to the same group).
+	if (m_batch != nullptr)
+	{
+		m_batch->Submit(this);
+		m_batch->UpdateGroups(m_batchSlot / BrainBatch::BATCH_WIDTH, 1);
+		return;
+	}
 
 	//-------------------------------------------------------------------------
 	// Swap the previous and current neuron activation buffers.
 
+	SwapActivations();
+
+	//-------------------------------------------------------------------------
+	// Compute the updated activation values for the internal and output
+	// neurons, then update Hebbian learning for all synapses.
+
+	bool isLearning = AdvanceLearningTick();
+	if (m_denseWeights != nullptr)
+		UpdateDense(isLearning);
+	else if (m_compactWeights != nullptr)
+		UpdateCompact(isLearning);
+	else
+		UpdateSparse(isLearning);
+}
+
+void Brain::SyncWeights()
+{
+	if (m_batch != nullptr)
+	{
+		m_batch->FetchWeights(this);
+	}
+	else if (m_denseWeights != nullptr)
+	{
+		for (unsigned int k = 0; k < m_numSynapses; ++k)
+		{
+			m_synapses[k].weight = m_denseWeights[((m_synapses[k].neuronTo -
+				m_numInputNeurons) * m_denseStride) + m_synapses[k].neuronFrom];
+		}
+	}
+	else if (m_sparseWeights != nullptr)
+	{
+		for (unsigned int k = 0; k < m_numSynapses; ++k)
+			m_synapses[k].weight = m_sparseWeights[k];
+	}
+}
+
+Synapse Brain::GetSynapse(unsigned int index) const
+{
+	if (m_compactWeights == nullptr)
+		return m_synapses[index];
+
+	// Rebuild the synapse from its place in the dense layout.
+	unsigned int row = index / m_numNeurons;
+	unsigned int column = index % m_numNeurons;
+	unsigned int compactIndex = (row * m_denseStride) + column;
+	Synapse synapse;
+	synapse.neuronFrom = column;
+	synapse.neuronTo = m_numInputNeurons + row;
+	synapse.learningRate = m_compactLearningRateSigns[compactIndex] *
+		m_compactLearningRateMagnitude;
+	if (m_weightPrecision == WEIGHT_PRECISION_FLOAT16)
+		synapse.weight = HalfToFloat(((const unsigned short*) m_compactWeights)[compactIndex]);
+	else
+		synapse.weight = ((const signed char*) m_compactWeights)[compactIndex] * m_compactRowScales[row];
+	return synapse;
+}
+
+void Brain::SwapActivations()
+{
 	float* tempActivations = m_currNeuronActivations;
 	m_currNeuronActivations = m_prevNeuronActivations;
 	m_prevNeuronActivations = tempActivations;
 
-	//-------------------------------------------------------------------------
-	// Compute the updated activation values for the internal and output neurons.
+	// Carry the input activations over into the current buffer, so they
+	// can still be read (and written in place) after the update.
+	memcpy(m_currNeuronActivations, m_prevNeuronActivations,
+		m_numInputNeurons * sizeof(float));
+}
+
+void Brain::CountConnectedNeurons()
+{
+	std::vector<bool> isConnected(m_numNeurons, false);
+	for (unsigned int i = m_numInputNeurons; i < m_numInputNeurons + m_numOutputNeurons; ++i)
+		isConnected[i] = true;
+	for (unsigned int k = 0; k < m_numSynapses; ++k)
+	{
+		isConnected[m_synapses[k].neuronFrom] = true;
+		isConnected[m_synapses[k].neuronTo] = true;
+	}
+
+	m_numConnectedNeurons = 0;
+	for (unsigned int i = 0; i < m_numNeurons; ++i)
+	{
+		if (isConnected[i])
+			m_numConnectedNeurons++;
+	}
+}
+
+bool Brain::AdvanceLearningTick()
+{
+	if (!m_hasLearningSynapses)
+		return false;
+
+	m_learningTick++;
+	if (m_learningTick < m_learningInterval)
+		return false;
+	m_learningTick = 0;
+	return true;
+}
+
+void Brain::UpdateSparse(bool isLearning)
+{
+	unsigned int i, k;
+
+	int firstOutputNeuron = m_numInputNeurons;
+	float sigmoidSlope = 1.0f;
 
 	for (i = firstOutputNeuron; i < m_numNeurons; ++i)
 	{
@@ -135,49 +720,114 @@ void Brain::Update()
 		float activation = m_neurons[i].bias;
 
 		// Sum up the input activations to this neuron multiplied
-		// by their synapse weights.
+		// by their synapse weights, keeping the inputs for learning.
 		for (k = m_neurons[i].synapsesBegin; k < m_neurons[i].synapsesEnd; ++k)
 		{
-			activation += m_synapses[k].weight *
-				m_prevNeuronActivations[m_synapses[k].neuronFrom];
+			float input = m_prevNeuronActivations[m_sparseNeuronFrom[k]];
+			m_sparseInputs[k] = input;
+			activation += m_sparseWeights[k] * input;
 		}
+		m_currNeuronActivations[i] = activation;
+	}
 
-		if (m_neurons[i].synapsesBegin == m_neurons[i].synapsesEnd)
-			m_currNeuronActivations[i] = 0.0f;
-		else
-			// Apply the sigmoid function to the resulting activation sum.
-			m_currNeuronActivations[i] = Sigmoid(activation, sigmoidSlope);
+	// Apply the sigmoid function to the resulting activation sums. A
+	// neuron left without synapses by pruning still outputs its bias.
+	SigmoidFunctions::Apply(m_sigmoidFunction, m_currNeuronActivations +
+		firstOutputNeuron, m_numNeurons - firstOutputNeuron, sigmoidSlope);
+
+	if (!isLearning)
+		return;
+
+	HebbianConstants<BrainLanes> constants(m_maxWeight, m_decayRate);
+	HebbianConstants<ScalarLanes> scalarConstants(m_maxWeight, m_decayRate);
+	for (i = firstOutputNeuron; i < m_numNeurons; ++i)
+	{
+		const Neuron& neuron = m_neurons[i];
+		HebbianRow<BrainLanes>(m_sparseWeights + neuron.synapsesBegin,
+			m_sparseLearningRates + neuron.synapsesBegin,
+			m_sparseInputs + neuron.synapsesBegin,
+			neuron.synapsesEnd - neuron.synapsesBegin,
+			m_currNeuronActivations[i], constants, scalarConstants);
 	}
-	
-	//-------------------------------------------------------------------------
-	// Update Hebbian learning for all synapses.
+}
 
-	float halfMaxWeight = 0.5f * m_maxWeight;
+void Brain::UpdateDense(bool isLearning)
+{
+	unsigned int numRows = m_numNeurons - m_numInputNeurons;
+	float* activations = m_currNeuronActivations + m_numInputNeurons;
+	float sigmoidSlope = 1.0f;
 
-	for (k = 0; k < m_numSynapses; ++k)
+	if (m_denseKernel != nullptr)
 	{
-		Synapse& synapse = m_synapses[k];
-		if (synapse.learningRate == 0.0f)
-			continue;
+		DenseBrainKernelParams params;
+		params.weights = m_denseWeights;
+		params.learningRates = m_denseLearningRates;
+		params.rowNeurons = m_neurons + m_numInputNeurons;
+		params.numRows = numRows;
+		params.prevActivations = m_prevNeuronActivations;
+		params.activations = activations;
+		params.sigmoidFunction = m_sigmoidFunction;
+		params.maxWeight = m_maxWeight;
+		params.decayRate = m_decayRate;
+		params.isLearning = isLearning;
+		m_denseKernel(params);
+		return;
+	}
+
+	// Sum up the input activations to each neuron multiplied by their
+	// synapse weights, then add in the bias terms.
+	DenseMultiply<BrainLanes>(m_denseWeights, m_denseStride, numRows,
+		m_prevNeuronActivations, activations);
+	for (unsigned int i = 0; i < numRows; ++i)
+		activations[i] += m_neurons[m_numInputNeurons + i].bias;
+
+	// Apply the sigmoid function to the resulting activation sums.
+	SigmoidFunctions::Apply(m_sigmoidFunction, activations, numRows, sigmoidSlope);
 
-		// Increase weight based on activation values of connected neurons.
-		synapse.weight += synapse.learningRate
-			* (m_currNeuronActivations[synapse.neuronTo] - 0.5f)
-			* (m_prevNeuronActivations[synapse.neuronFrom] - 0.5f);
+	if (!isLearning)
+		return;
 
-		// Gradually decay synapse weights which are above half of max-weight.
-		// The higher weight is above half max-weight, the quicker it will decay.
-		if (Math::Abs(synapse.weight) > halfMaxWeight)
+	// The padding columns have no learning rate, so they are left as zero.
+	HebbianConstants<BrainLanes> constants(m_maxWeight, m_decayRate);
+	HebbianConstants<ScalarLanes> scalarConstants(m_maxWeight, m_decayRate);
+	for (unsigned int row = 0; row < numRows; ++row)
+	{
+		HebbianRow<BrainLanes>(m_denseWeights + (row * m_denseStride),
+			m_denseLearningRates + (row * m_denseStride),
+			m_prevNeuronActivations, m_denseStride, activations[row],
+			constants, scalarConstants);
+	}
+}
+
+// Update like UpdateDense(), decoding each row of weights when it is used.
+// Each row's activation is complete once its weights are summed, so its
+// learning is applied straight away, while the row is still decoded.
+void Brain::UpdateCompact(bool isLearning)
+{
+	unsigned int numRows = m_numNeurons - m_numInputNeurons;
+	float* activations = m_currNeuronActivations + m_numInputNeurons;
+	float sigmoidSlope = 1.0f;
+
+	HebbianConstants<BrainLanes> constants(m_maxWeight, m_decayRate);
+	HebbianConstants<ScalarLanes> scalarConstants(m_maxWeight, m_decayRate);
+
+	for (unsigned int row = 0; row < numRows; ++row)
+	{
+		DecodeCompactWeights(row, m_compactRowWeights);
+		DenseMultiply<BrainLanes>(m_compactRowWeights, m_denseStride, 1,
+			m_prevNeuronActivations, activations + row);
+		activations[row] = SigmoidFunctions::Evaluate(m_sigmoidFunction,
+			activations[row] + m_neurons[m_numInputNeurons + row].bias,
+			sigmoidSlope);
+
+		if (isLearning)
 		{
-			synapse.weight *= 1.0f - (1.0f - m_decayRate) *
-				((Math::Abs(synapse.weight) - halfMaxWeight) / halfMaxWeight);
+			DecodeCompactLearningRates(row, m_compactRowLearningRates);
+			HebbianRow<BrainLanes>(m_compactRowWeights, m_compactRowLearningRates,
+				m_prevNeuronActivations, m_denseStride, activations[row],
+				constants, scalarConstants);
+			EncodeCompactWeights(row, m_compactRowWeights);
 		}
-
-		// Clamp weight (sign depending on learning rate).
-		if (synapse.learningRate >= 0.0f)
-			synapse.weight = Math::Clamp(synapse.weight, 0.0f, m_maxWeight);
-		if (synapse.learningRate < 0.0f) 
-			synapse.weight = Math::Clamp(synapse.weight, -m_maxWeight, -1e-10f);
 	}
 }
 
@@ -186,9 +836,12 @@ void Brain::Update()
 // Static functions
 //-----------------------------------------------------------------------------
 
-float Brain::Sigmoid(float x, float slope)
+unsigned int Brain::GetPaddedNeuronCount(unsigned int numNeurons)
 {
-    return (1.0f / (1.0f + Math::Exp(-x * slope)));
+	return ((numNeurons + BRAIN_PADDING - 1) / BRAIN_PADDING) * BRAIN_PADDING;
 }
 
-
+unsigned int Brain::AlignMemorySize(unsigned int size)
+{
+	return ((size + MEMORY_ALIGNMENT - 1) / MEMORY_ALIGNMENT) * MEMORY_ALIGNMENT;
+}
@@ -2,7 +2,12 @@
 #define _BRAIN_H_
 
 #include <vector>
+#include <fstream>
 #include <utilities/Random.h>
+#include "SigmoidFunctions.h"
+
+class BrainBatch;
+struct DenseBrainKernelParams;
 
 
 // Brain implementation modified from Polyworld:
@@ -38,6 +43,18 @@ enum InputNeurons
 	SIGHT_INPUTS_BEGIN = NUM_NON_SIGHT_INPUTS
 };
 
+//-----------------------------------------------------------------------------
+// WeightPrecision - How the weights of dense brains are stored.
+//-----------------------------------------------------------------------------
+enum WeightPrecision
+{
+	WEIGHT_PRECISION_FLOAT32 = 0,	// 32-bit floats.
+	WEIGHT_PRECISION_FLOAT16,		// 16-bit (half precision) floats.
+	WEIGHT_PRECISION_INT8,			// 8-bit integers, with a scale for each row.
+
+	NUM_WEIGHT_PRECISIONS
+};
+
 //-----------------------------------------------------------------------------
 // Neuron
 //-----------------------------------------------------------------------------
@@ -67,6 +84,9 @@ struct Synapse
 class Brain
 {
 public:
+	// The alignment of the brain's memory block and of each array in it.
+	static const unsigned int MEMORY_ALIGNMENT = 64;
+
 	//-------------------------------------------------------------------------
 	// Constructor & destructor
 
@@ -82,11 +102,51 @@ public:
 	void Initialize(unsigned int numNeurons,
 		unsigned int numSynapses, float initialActivation);
 
+	// Copy the neurons, synapses and activations of another brain whose
+	// weight arrays haven't been built yet.
+	void CopyTopology(const Brain& source);
+
 	void ConfigNeuron(unsigned int neuronIndex, float bias,
 		unsigned int synapsesBegin, unsigned int synapsesEnd);
 
 	void ConfigSynapse(unsigned int synapseIndex, float weight,
 		float learningRate, unsigned int neuronFrom, unsigned int neuronTo);
+
+	// Build the weight and learning rate arrays which updates work on,
+	// after the synapses have been set up. If dense weights are requested,
+	// and every internal and output neuron has one synapse from every
+	// neuron ordered by the neuron they come from, the arrays are dense
+	// row-major matrices used with SIMD matrix-vector kernels. Otherwise
+	// they follow the synapse list.
+	//
+	// Dense brains can store their weights with reduced precision, if all
+	// of their learning rates share one magnitude. Then each synapse keeps
+	// only its weight and the sign of its learning rate, as the neurons it
+	// connects are implied by the layout, and the synapse list is freed.
+	// Weights are decoded to floats a row at a time during updates. Brains
+	// with learning synapses use 16-bit floats when 8-bit integers are
+	// requested, as 8-bit rows would lose small learning steps.
+	void InitWeights(bool useDenseWeights,
+		WeightPrecision weightPrecision = WEIGHT_PRECISION_FLOAT32);
+
+	// Select how dense weights are updated: with a kernel specialized for
+	// the brain's number of neurons, if there is one, or the generic
+	// kernel. Call this after InitWeights().
+	void SelectDenseKernel(bool useSpecializedKernels);
+
+	// Remove the synapses which can never affect the output neurons: those
+	// with no weight or learning rate, self-connections, synapses from
+	// unused input neurons, and synapses to or from internal neurons with
+	// no path to an output neuron. The remaining synapses are compacted so
+	// each neuron's incoming synapses stay contiguous (compressed sparse
+	// rows). Neuron indices are unchanged, so the removed neurons remain
+	// in place without any synapses. Call this before InitWeights().
+	void Prune(const std::vector<bool>& isInputUsed);
+
+	// Read or write the brain's neurons, synapses and current activations.
+	// The weight arrays must be initialized after reading.
+	void Read(std::ifstream& fileIn);
+	void Write(std::ofstream& fileOut);
 	
 	//-------------------------------------------------------------------------
 	// Simulation
@@ -94,10 +154,19 @@ public:
 	// Update the neural network for a number of cycles, while sending
 	// random signals to the input neurons.
 	void PreBirth(unsigned int numCycles, RNG& random);
+
+	// Set all input neurons to random activations, as for one pre-birth
+	// cycle.
+	void RandomizeInputs(RNG& random);
 	
-	// Update the neural network for one tick.
+	// Update the neural network for one tick. Brains which belong to a
+	// batch are updated by their batch.
 	void Update();
 
+	// Copy the weights learned since the brain was set up back into its
+	// synapse list, from the weight arrays or from the brain's batch.
+	void SyncWeights();
+
 	//-------------------------------------------------------------------------
 	// Getters
 
@@ -106,10 +175,21 @@ public:
 	inline unsigned int GetNumOutputNeurons() const { return m_numOutputNeurons; }
 	inline unsigned int GetNumInternalNeurons() const { return (m_numNeurons - m_numInputNeurons - m_numOutputNeurons); }
 	inline unsigned int GetNumSynapses() const { return m_numSynapses; }
+	inline unsigned int GetNumConnectedNeurons() const { return m_numConnectedNeurons; }
 	inline const Neuron& GetNeuron(unsigned int index) const { return m_neurons[index]; }
-	inline const Synapse& GetSynapse(unsigned int index) const { return m_synapses[index]; }
+	Synapse GetSynapse(unsigned int index) const; // Call SyncWeights() first.
 	inline float GetNeuronActivation(unsigned int index) const { return m_currNeuronActivations[index]; }
 	inline float GetPrevNeuronActivation(unsigned int index) const { return m_prevNeuronActivations[index]; }
+	inline float* GetNeuronActivations() { return m_currNeuronActivations; }
+	inline bool IsDense() const { return (m_denseWeights != nullptr); }
+	inline bool IsCompact() const { return (m_compactWeights != nullptr); }
+	inline bool IsSpecialized() const { return (m_denseKernel != nullptr); }
+	inline WeightPrecision GetWeightPrecision() const { return m_weightPrecision; }
+	inline bool IsBatched() const { return (m_batch != nullptr); }
+	inline BrainBatch* GetBatch() { return m_batch; }
+
+	// Get the number of bytes used by the brain, including its memory block.
+	inline unsigned int GetMemorySize() const { return (sizeof(Brain) + m_memorySize); }
 
 	//-------------------------------------------------------------------------
 	// Setters
@@ -118,34 +198,136 @@ public:
 	inline void SetNumOutputNeurons(unsigned int numOutputNeurons) { m_numOutputNeurons = numOutputNeurons; }
 	inline void SetDecayRate(float decayRate) { m_decayRate = decayRate; }
 	inline void SetMaxWeight(float maxWeight) { m_maxWeight = maxWeight; }
+	inline void SetLearningInterval(unsigned int learningInterval) { m_learningInterval = learningInterval; }
+	inline void SetSigmoidFunction(SigmoidFunction sigmoidFunction) { m_sigmoidFunction = sigmoidFunction; }
 	inline void SetNeuronActivation(unsigned int index, float activation) { m_currNeuronActivations[index] = activation; }
 
 private:
 	//-------------------------------------------------------------------------
 	// Static functions
 
-	// Compute the sigmoid function with the given slope, used to 
-	// normalize activation values back into the range of 0 to 1.
-	// Positive x-values will yield y-values between 0.5 and 1
-	// Negative x-values will yield y-values between 0 and 0.5
-	static float Sigmoid(float x, float slope);
+	// Get the number of activation values to allocate for the given number
+	// of neurons, padded so SIMD kernels can read whole vectors.
+	static unsigned int GetPaddedNeuronCount(unsigned int numNeurons);
+
+	// Round a size up to a multiple of the memory alignment.
+	static unsigned int AlignMemorySize(unsigned int size);
+
+	// The weight arrays which a memory block can hold.
+	enum WeightLayout
+	{
+		WEIGHTS_NONE = 0,
+		WEIGHTS_DENSE,
+		WEIGHTS_SPARSE,
+		WEIGHTS_COMPACT, // Replaces the synapse list.
+	};
+
+	// Allocate a new memory block with room for the weight arrays of the
+	// given layout, and move the activations, neurons and synapses into it.
+	// The weight arrays are left uninitialized. Compact layouts have no
+	// synapse list.
+	void AllocateMemory(WeightLayout weightLayout,
+		WeightPrecision weightPrecision = WEIGHT_PRECISION_FLOAT32);
+	void FreeMemory();
+
+	bool IsDenseLayout() const;
+	bool GetLearningRateMagnitude(float& outMagnitude) const;
+	void InitDenseWeights();
+	void InitSparseWeights();
+	void InitCompactWeights(WeightPrecision weightPrecision, float learningRateMagnitude);
+
+	// Decode a row of compact weights or learning rates into floats, or
+	// encode a row of weights from floats.
+	void DecodeCompactWeights(unsigned int row, float* outWeights) const;
+	void DecodeCompactLearningRates(unsigned int row, float* outLearningRates) const;
+	void EncodeCompactWeights(unsigned int row, const float* weights);
+	void FreeWeights();
+
+	// Swap the previous and current activation buffers, carrying over the
+	// input activations.
+	void SwapActivations();
+
+	// Count an update, returning true if Hebbian learning runs during it.
+	bool AdvanceLearningTick();
+
+	// Count the output neurons and the neurons connected to any synapse.
+	void CountConnectedNeurons();
+
+	// Compute the activations of the internal and output neurons, then
+	// apply Hebbian learning, using the sparse or the dense weight arrays.
+	void UpdateSparse(bool isLearning);
+	void UpdateDense(bool isLearning);
+	void UpdateCompact(bool isLearning);
 
 	friend class Agent;
+	friend class BrainBatch;
 
 private:
 	
+	// All of the brain's arrays live in one block of memory, each aligned
+	// for SIMD: the current and previous activations, then the weight
+	// arrays, then the neurons and synapses.
+	unsigned char*	m_memoryBlock; // As allocated, before alignment.
+	unsigned char*	m_memory;
+	unsigned int	m_memorySize;
+
 	Neuron*			m_neurons;
 	float*			m_currNeuronActivations;
 	float*			m_prevNeuronActivations; // Activation values for each neuron from previous tick.
 	unsigned int	m_numNeurons;
 	unsigned int	m_numInputNeurons;
 	unsigned int	m_numOutputNeurons;
+	unsigned int	m_numConnectedNeurons; // Neurons left after pruning.
 
 	Synapse*		m_synapses;
 	unsigned int	m_numSynapses;
 
+	// Dense weights and learning rates, with one row for each internal and
+	// output neuron and one padded column for each neuron.
+	float*			m_denseWeights;
+	float*			m_denseLearningRates;
+	unsigned int	m_denseStride;
+
+	// The kernel specialized for the dense layout, or nullptr to use the
+	// generic dense update.
+	void			(*m_denseKernel)(const DenseBrainKernelParams& params);
+
+	// Compact weights, stored like the dense weights with the given
+	// precision. Int8 weights are multiplied by their row's scale. The
+	// learning rate of each synapse is its sign times the magnitude. The
+	// row arrays hold one row of weights and learning rates as floats
+	// during updates.
+	WeightPrecision	m_weightPrecision;
+	unsigned char*	m_compactWeights;
+	float*			m_compactRowScales;
+	signed char*	m_compactLearningRateSigns;
+	float			m_compactLearningRateMagnitude;
+	float*			m_compactRowWeights;
+	float*			m_compactRowLearningRates;
+
+	// Sparse weights, learning rates and source neurons, in synapse order.
+	// The inputs array holds the source activations gathered during the
+	// update, for learning.
+	float*			m_sparseWeights;
+	float*			m_sparseLearningRates;
+	unsigned int*	m_sparseNeuronFrom;
+	float*			m_sparseInputs;
+
+	bool			m_hasLearningSynapses;
+	unsigned int	m_learningInterval; // Learn once every this many updates.
+	unsigned int	m_learningTick;
+
+	// The batch which updates this brain along with the others of its
+	// species, and the brain's slot within it.
+	BrainBatch*		m_batch;
+	unsigned int	m_batchSlot;
+
 	float			m_decayRate;
 	float			m_maxWeight;
+
+	// The sigmoid function used to normalize activation values back into
+	// the range of 0 to 1.
+	SigmoidFunction	m_sigmoidFunction;
 };
 
 
@@ -0,0 +1,300 @@
+#include "BrainBatch.h"
+#include "BrainKernels.h"
+#include <string.h>
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+BrainBatch::BrainBatch() :
+	m_numNeurons(0),
+	m_numInputNeurons(0),
+	m_numRows(0),
+	m_maxWeight(0.0f),
+	m_decayRate(0.0f),
+	m_sigmoidFunction(SIGMOID_EXACT),
+	m_numBrains(0)
+{
+}
+
+BrainBatch::~BrainBatch()
+{
+	// Return the weights to any brains which outlive the batch.
+	for (unsigned int slot = 0; slot < m_slots.size(); ++slot)
+	{
+		if (m_slots[slot] != nullptr)
+			RemoveBrain(m_slots[slot]);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Brain management
+//-----------------------------------------------------------------------------
+
+bool BrainBatch::AddBrain(Brain* brain)
+{
+	if (brain->m_batch != nullptr || !brain->IsDense())
+		return false;
+
+	// The first brain decides the layout of the batch.
+	if (m_numBrains == 0)
+	{
+		m_numNeurons = brain->m_numNeurons;
+		m_numInputNeurons = brain->m_numInputNeurons;
+		m_numRows = m_numNeurons - m_numInputNeurons;
+		m_maxWeight = brain->m_maxWeight;
+		m_decayRate = brain->m_decayRate;
+		m_sigmoidFunction = brain->m_sigmoidFunction;
+		m_slots.clear();
+		m_freeSlots.clear();
+		m_weights.clear();
+		m_learningRates.clear();
+		m_biases.clear();
+		m_activeLanes.clear();
+		m_learningLanes.clear();
+		m_activations.clear();
+		m_sums.clear();
+	}
+	else if (brain->m_numNeurons != m_numNeurons ||
+		brain->m_numInputNeurons != m_numInputNeurons ||
+		brain->m_maxWeight != m_maxWeight ||
+		brain->m_decayRate != m_decayRate ||
+		brain->m_sigmoidFunction != m_sigmoidFunction)
+	{
+		return false;
+	}
+
+	if (m_freeSlots.empty())
+		AddGroup();
+	unsigned int slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+	m_slots[slot] = brain;
+	m_numBrains++;
+	brain->m_batch = this;
+	brain->m_batchSlot = slot;
+
+	// Move the brain's weights, learning rates and biases into its lane.
+	for (unsigned int row = 0; row < m_numRows; ++row)
+	{
+		const float* rowWeights = brain->m_denseWeights + (row * brain->m_denseStride);
+		const float* rowLearningRates = brain->m_denseLearningRates + (row * brain->m_denseStride);
+		for (unsigned int i = 0; i < m_numNeurons; ++i)
+		{
+			unsigned int index = GetWeightIndex(slot, row, i);
+			m_weights[index] = rowWeights[i];
+			m_learningRates[index] = rowLearningRates[i];
+		}
+		m_biases[GetBiasIndex(slot, row)] = brain->m_neurons[m_numInputNeurons + row].bias;
+	}
+	return true;
+}
+
+void BrainBatch::RemoveBrain(Brain* brain)
+{
+	if (brain->m_batch != this)
+		return;
+
+	unsigned int slot = brain->m_batchSlot;
+	FetchWeights(brain);
+	brain->m_batch = nullptr;
+	brain->m_batchSlot = 0;
+
+	// Clear the lane so it no longer learns or produces activations.
+	for (unsigned int row = 0; row < m_numRows; ++row)
+	{
+		for (unsigned int i = 0; i < m_numNeurons; ++i)
+		{
+			unsigned int index = GetWeightIndex(slot, row, i);
+			m_weights[index] = 0.0f;
+			m_learningRates[index] = 0.0f;
+		}
+		m_biases[GetBiasIndex(slot, row)] = 0.0f;
+	}
+	m_activeLanes[slot] = 0.0f;
+	m_learningLanes[slot] = 0.0f;
+
+	m_slots[slot] = nullptr;
+	m_freeSlots.push_back(slot);
+	m_numBrains--;
+}
+
+void BrainBatch::FetchWeights(Brain* brain) const
+{
+	if (brain->m_batch != this)
+		return;
+
+	unsigned int slot = brain->m_batchSlot;
+	for (unsigned int row = 0; row < m_numRows; ++row)
+	{
+		Synapse* rowSynapses = brain->m_synapses + (row * m_numNeurons);
+		float* rowWeights = brain->m_denseWeights + (row * brain->m_denseStride);
+		for (unsigned int i = 0; i < m_numNeurons; ++i)
+		{
+			float weight = m_weights[GetWeightIndex(slot, row, i)];
+			rowSynapses[i].weight = weight;
+			rowWeights[i] = weight;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Update
+//-----------------------------------------------------------------------------
+
+void BrainBatch::Submit(Brain* brain)
+{
+	if (brain->m_batch == this)
+	{
+		m_activeLanes[brain->m_batchSlot] = 1.0f;
+		m_learningLanes[brain->m_batchSlot] = (brain->AdvanceLearningTick() ? 1.0f : 0.0f);
+	}
+}
+
+void BrainBatch::Update()
+{
+	UpdateGroups(0, GetNumGroups());
+}
+
+void BrainBatch::UpdateGroups(unsigned int firstGroup, unsigned int numGroups)
+{
+	for (unsigned int group = firstGroup; group < firstGroup + numGroups; ++group)
+		UpdateGroup(group);
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+// Add a group of empty slots. Its lanes have no weights or learning rates.
+void BrainBatch::AddGroup()
+{
+	unsigned int firstSlot = m_slots.size();
+	unsigned int numWeights = m_numRows * m_numNeurons * BATCH_WIDTH;
+
+	m_slots.resize(firstSlot + BATCH_WIDTH, nullptr);
+	m_weights.resize(m_weights.size() + numWeights, 0.0f);
+	m_learningRates.resize(m_learningRates.size() + numWeights, 0.0f);
+	m_biases.resize(m_biases.size() + (m_numRows * BATCH_WIDTH), 0.0f);
+	m_activeLanes.resize(m_activeLanes.size() + BATCH_WIDTH, 0.0f);
+	m_learningLanes.resize(m_learningLanes.size() + BATCH_WIDTH, 0.0f);
+	m_activations.resize(m_activations.size() + (m_numNeurons * BATCH_WIDTH), 0.0f);
+	m_sums.resize(m_sums.size() + (m_numRows * BATCH_WIDTH), 0.0f);
+
+	// Fill the lowest slots first.
+	for (unsigned int i = BATCH_WIDTH; i > 0; --i)
+		m_freeSlots.push_back(firstSlot + i - 1);
+}
+
+void BrainBatch::UpdateGroup(unsigned int group)
+{
+	typedef BrainLanes L;
+	typedef L::Type V;
+	typedef L::Mask M;
+
+	const unsigned int W = BATCH_WIDTH;
+	Brain** brains = m_slots.data() + (group * W);
+	float* activeLanes = m_activeLanes.data() + (group * W);
+	float* learningLanes = m_learningLanes.data() + (group * W);
+	float* weights = m_weights.data() + (group * m_numRows * m_numNeurons * W);
+	const float* learningRates = m_learningRates.data() + (group * m_numRows * m_numNeurons * W);
+	const float* biases = m_biases.data() + (group * m_numRows * W);
+	float* activations = m_activations.data() + (group * m_numNeurons * W);
+	float* sums = m_sums.data() + (group * m_numRows * W);
+
+	bool isAnyLaneActive = false;
+	for (unsigned int lane = 0; lane < W; ++lane)
+		isAnyLaneActive = isAnyLaneActive || (activeLanes[lane] != 0.0f);
+	if (!isAnyLaneActive)
+		return;
+
+	//-------------------------------------------------------------------------
+	// Gather the activations of the submitted brains into lanes.
+
+	for (unsigned int lane = 0; lane < W; ++lane)
+	{
+		if (activeLanes[lane] != 0.0f)
+		{
+			const float* brainActivations = brains[lane]->m_currNeuronActivations;
+			for (unsigned int i = 0; i < m_numNeurons; ++i)
+				activations[(i * W) + lane] = brainActivations[i];
+		}
+		else
+		{
+			for (unsigned int i = 0; i < m_numNeurons; ++i)
+				activations[(i * W) + lane] = 0.0f;
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// Compute the updated activation values for the internal and output
+	// neurons, summing the inputs in the same order as the sparse update.
+
+	for (unsigned int row = 0; row < m_numRows; ++row)
+	{
+		const float* rowWeights = weights + (row * m_numNeurons * W);
+		for (unsigned int lane = 0; lane < W; lane += L::WIDTH)
+		{
+			V sum = L::Load(biases + (row * W) + lane);
+			for (unsigned int i = 0; i < m_numNeurons; ++i)
+			{
+				sum = L::Add(sum, L::Mul(L::Load(rowWeights + (i * W) + lane),
+					L::Load(activations + (i * W) + lane)));
+			}
+			L::Store(sums + (row * W) + lane, sum);
+		}
+	}
+	SigmoidFunctions::Apply(m_sigmoidFunction, sums, m_numRows * W, 1.0f);
+
+	//-------------------------------------------------------------------------
+	// Update Hebbian learning for all synapses, only changing the weights of
+	// brains which are learning during this update.
+
+	bool isAnyLaneLearning = false;
+	for (unsigned int lane = 0; lane < W; ++lane)
+		isAnyLaneLearning = isAnyLaneLearning || (learningLanes[lane] != 0.0f);
+
+	if (isAnyLaneLearning)
+	{
+		HebbianConstants<L> constants(m_maxWeight, m_decayRate);
+		for (unsigned int lane = 0; lane < W; lane += L::WIDTH)
+		{
+			M isLearning = L::Greater(L::Load(learningLanes + lane), constants.zero);
+
+			for (unsigned int row = 0; row < m_numRows; ++row)
+			{
+				V curr = L::Load(sums + (row * W) + lane);
+				float* rowWeights = weights + (row * m_numNeurons * W);
+				const float* rowLearningRates = learningRates + (row * m_numNeurons * W);
+
+				for (unsigned int i = 0; i < m_numNeurons; ++i)
+				{
+					unsigned int index = (i * W) + lane;
+					L::Store(rowWeights + index, HebbianLanes<L>(
+						L::Load(rowWeights + index), L::Load(rowLearningRates + index),
+						curr, L::Load(activations + index), isLearning, constants));
+				}
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// Scatter the new activations back into the submitted brains.
+
+	for (unsigned int lane = 0; lane < W; ++lane)
+	{
+		if (activeLanes[lane] == 0.0f)
+			continue;
+
+		Brain* brain = brains[lane];
+		brain->SwapActivations();
+		float* brainActivations = brain->m_currNeuronActivations + m_numInputNeurons;
+		for (unsigned int row = 0; row < m_numRows; ++row)
+			brainActivations[row] = sums[(row * W) + lane];
+		activeLanes[lane] = 0.0f;
+		learningLanes[lane] = 0.0f;
+	}
+}
@@ -0,0 +1,110 @@
+#ifndef _BRAIN_BATCH_H_
+#define _BRAIN_BATCH_H_
+
+#include "Brain.h"
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// BrainBatch - Updates the dense brains of all agents of a species at once.
+//              The brains of a species share one dense layout, and only
+//              differ in their weights, biases and activations. So the
+//              batch stores their weights interleaved across brains: each
+//              group of BATCH_WIDTH brains keeps one lane per brain for
+//              every synapse. The forward pass and Hebbian learning then run
+//              with SIMD across the brains of a group, without gathers or
+//              branches, and each group can be updated independently.
+//
+//              While a brain is in a batch, the batch owns its weights.
+//              They are copied back into the brain's synapses by
+//              Brain::SyncWeights().
+//-----------------------------------------------------------------------------
+class BrainBatch
+{
+public:
+	// The number of brains in a group, which is the widest lane width.
+	static const unsigned int BATCH_WIDTH = 8;
+
+	//-------------------------------------------------------------------------
+	// Constructor & destructor
+
+	BrainBatch();
+	~BrainBatch();
+
+	//-------------------------------------------------------------------------
+	// Getters
+
+	inline unsigned int GetNumBrains() const { return m_numBrains; }
+	inline unsigned int GetNumGroups() const { return (m_slots.size() / BATCH_WIDTH); }
+
+	//-------------------------------------------------------------------------
+	// Brain management
+
+	// Add a dense brain to the batch, which takes over its weights. Returns
+	// false if the brain's layout doesn't match the other brains in the
+	// batch, in which case it must be updated on its own.
+	bool AddBrain(Brain* brain);
+
+	// Remove a brain from the batch, leaving its weights in the brain.
+	void RemoveBrain(Brain* brain);
+
+	// Copy a brain's weights from the batch into its synapses.
+	void FetchWeights(Brain* brain) const;
+
+	//-------------------------------------------------------------------------
+	// Update
+
+	// Mark a brain to be updated by the next call to Update(). Its input
+	// activations must already be set. This counts towards the brain's
+	// learning interval.
+	void Submit(Brain* brain);
+
+	// Update all submitted brains, just as Brain::Update() would.
+	void Update();
+
+	// Update the submitted brains within a range of groups. Different
+	// groups may be updated on different threads.
+	void UpdateGroups(unsigned int firstGroup, unsigned int numGroups);
+
+
+private:
+	void AddGroup();
+	void UpdateGroup(unsigned int group);
+
+	inline unsigned int GetWeightIndex(unsigned int slot, unsigned int row, unsigned int neuron) const
+	{
+		return ((((slot / BATCH_WIDTH) * m_numRows + row) * m_numNeurons + neuron) *
+			BATCH_WIDTH) + (slot % BATCH_WIDTH);
+	}
+
+	inline unsigned int GetBiasIndex(unsigned int slot, unsigned int row) const
+	{
+		return ((((slot / BATCH_WIDTH) * m_numRows) + row) * BATCH_WIDTH) + (slot % BATCH_WIDTH);
+	}
+
+
+private:
+	// The layout shared by all brains in the batch.
+	unsigned int		m_numNeurons;
+	unsigned int		m_numInputNeurons;
+	unsigned int		m_numRows; // internal and output neurons
+	float				m_maxWeight;
+	float				m_decayRate;
+	SigmoidFunction		m_sigmoidFunction;
+
+	std::vector<Brain*>			m_slots; // The brain in each slot, or nullptr.
+	std::vector<unsigned int>	m_freeSlots;
+	unsigned int				m_numBrains;
+
+	// Per-group arrays, with the brains of a group interleaved in lanes.
+	std::vector<float>	m_weights;			// [group][row][neuron][lane]
+	std::vector<float>	m_learningRates;	// [group][row][neuron][lane]
+	std::vector<float>	m_biases;			// [group][row][lane]
+	std::vector<float>	m_activeLanes;		// [group][lane], 1 if submitted.
+	std::vector<float>	m_learningLanes;	// [group][lane], 1 if learning this update.
+	std::vector<float>	m_activations;		// [group][neuron][lane], scratch
+	std::vector<float>	m_sums;				// [group][row][lane], scratch
+};
+
+
+#endif // _BRAIN_BATCH_H_
@@ -0,0 +1,110 @@
+#include "BrainCache.h"
+#include <string.h>
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+BrainCache::BrainCache() :
+	m_capacity(0),
+	m_numHits(0),
+	m_numMisses(0)
+{
+}
+
+BrainCache::~BrainCache()
+{
+	Clear();
+}
+
+void BrainCache::Clear()
+{
+	for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+		delete it->second.topology;
+	m_entries.clear();
+	m_order.clear();
+	m_numHits = 0;
+	m_numMisses = 0;
+}
+
+void BrainCache::SetCapacity(unsigned int capacity)
+{
+	m_capacity = capacity;
+	while (m_entries.size() > m_capacity)
+		RemoveOldest();
+}
+
+
+//-----------------------------------------------------------------------------
+// Lookup
+//-----------------------------------------------------------------------------
+
+const BrainTopology* BrainCache::GetTopology(const Genome& genome, const SpeciesConfig& config)
+{
+	// Only the gene and brain settings affect how a brain grows.
+	unsigned long long configHash = Hash(&config.genes, sizeof(config.genes), 14695981039346656037ull);
+	configHash = Hash(&config.brain, sizeof(config.brain), configHash);
+	unsigned long long key = Hash(genome.GetData(), genome.GetSize(), configHash);
+
+	auto it = m_entries.find(key);
+	if (it != m_entries.end())
+	{
+		Entry& entry = it->second;
+		if (entry.configHash == configHash &&
+			entry.genes.size() == genome.GetSize() &&
+			memcmp(entry.genes.data(), genome.GetData(), genome.GetSize()) == 0)
+		{
+			m_numHits++;
+			return entry.topology;
+		}
+
+		// A different genome with the same hash replaces the old one.
+		delete entry.topology;
+		entry.topology = nullptr;
+	}
+	else
+	{
+		if (m_entries.size() >= m_capacity)
+			RemoveOldest();
+		it = m_entries.insert(std::make_pair(key, Entry())).first;
+		m_order.push_back(key);
+	}
+
+	m_numMisses++;
+	Entry& entry = it->second;
+	entry.configHash = configHash;
+	entry.genes.assign(genome.GetData(), genome.GetData() + genome.GetSize());
+	entry.topology = new BrainTopology();
+	genome.GrowBrainTopology(*entry.topology, config);
+	return entry.topology;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+// FNV-1a hash of a block of bytes, continuing from a previous hash.
+unsigned long long BrainCache::Hash(const void* data,
+	unsigned int size, unsigned long long hash)
+{
+	const unsigned char* bytes = (const unsigned char*) data;
+	for (unsigned int i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void BrainCache::RemoveOldest()
+{
+	if (m_order.empty())
+		return;
+
+	auto it = m_entries.find(m_order.front());
+	delete it->second.topology;
+	m_entries.erase(it);
+	m_order.pop_front();
+}
@@ -0,0 +1,87 @@
+#ifndef _BRAIN_CACHE_H_
+#define _BRAIN_CACHE_H_
+
+#include "Brain.h"
+#include "Genome.h"
+#include <deque>
+#include <map>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// BrainTopology - A brain as grown from a genome, before its random initial
+//                 weights are drawn. The synapses which get random weights
+//                 hold a tiny weight of the right sign in their place.
+//-----------------------------------------------------------------------------
+struct BrainTopology
+{
+	Brain				brain;
+	std::vector<bool>	isWeightPositive; // The sign of each random weight, in the order they are drawn.
+	std::vector<int>	synapseWeights; // The index of each synapse's random weight, or -1.
+};
+
+
+//-----------------------------------------------------------------------------
+// BrainCache - Keeps the brain topologies grown from recent genomes, so a
+//              brain grown from an identical genome (such as an elite clone
+//              from the fittest list) can skip growing and pruning, and
+//              only draw its random weights. Topologies are looked up by a
+//              hash of the genome and of the species config settings which
+//              affect growth, and the oldest is dropped when it is full.
+//-----------------------------------------------------------------------------
+class BrainCache
+{
+public:
+	//-------------------------------------------------------------------------
+	// Constructor & destructor
+
+	BrainCache();
+	~BrainCache();
+
+	// Remove all topologies, and reset the hit and miss counts.
+	void Clear();
+
+	// Set the number of topologies to keep. Zero disables the cache.
+	void SetCapacity(unsigned int capacity);
+
+	//-------------------------------------------------------------------------
+	// Getters
+
+	inline unsigned int GetCapacity() const { return m_capacity; }
+	inline unsigned int GetSize() const { return m_entries.size(); }
+	inline unsigned int GetNumHits() const { return m_numHits; }
+	inline unsigned int GetNumMisses() const { return m_numMisses; }
+
+	//-------------------------------------------------------------------------
+	// Lookup
+
+	// Get the topology grown from a genome with a species config, growing
+	// and caching it if it isn't already cached. The topology stays valid
+	// until the next call. The cache must have a capacity.
+	const BrainTopology* GetTopology(const Genome& genome, const SpeciesConfig& config);
+
+
+private:
+	struct Entry
+	{
+		unsigned long long			configHash;
+		std::vector<unsigned char>	genes;
+		BrainTopology*				topology;
+	};
+
+	static unsigned long long Hash(const void* data,
+		unsigned int size, unsigned long long hash);
+
+	void RemoveOldest();
+
+
+private:
+	unsigned int							m_capacity;
+	std::map<unsigned long long, Entry>		m_entries;
+	std::deque<unsigned long long>			m_order; // Keys from oldest to newest.
+	unsigned int							m_numHits;
+	unsigned int							m_numMisses;
+};
+
+
+#endif // _BRAIN_CACHE_H_
@@ -0,0 +1,389 @@
+#ifndef _BRAIN_KERNELS_H_
+#define _BRAIN_KERNELS_H_
+
+#include <utilities/SIMD.h>
+
+
+//-----------------------------------------------------------------------------
+// Brain kernels - SIMD building blocks for updating brains, written as
+//                 templates over the lane types in "utilities/SIMD.h".
+//-----------------------------------------------------------------------------
+
+// The widest lane type enabled for this build.
+#if defined(SEAL_SIMD_AVX2)
+	typedef AVX2Lanes BrainLanes;
+#elif defined(SEAL_SIMD_SSE2)
+	typedef SSELanes BrainLanes;
+#else
+	typedef ScalarLanes BrainLanes;
+#endif
+
+// Activation arrays and weight rows are padded to a multiple of the widest
+// lane width. The padding is zero.
+static const unsigned int BRAIN_PADDING = 8;
+
+// Compute e^x for a vector, using a polynomial after reducing x to the range
+// [-ln(2)/2, ln(2)/2]. Based on the Cephes library's expf(), which is
+// accurate to about one unit in the last place.
+template <class L>
+inline typename L::Type ExpLanes(typename L::Type x)
+{
+	typedef typename L::Type V;
+
+	x = L::Min(L::Max(x, L::Set(-87.0f)), L::Set(87.0f));
+
+	// Split x into n*ln(2) + r, with ln(2) in two parts for precision.
+	V n = L::Round(L::Mul(x, L::Set(1.44269504088896341f)));
+	V r = L::Sub(x, L::Mul(n, L::Set(0.693359375f)));
+	r = L::Sub(r, L::Mul(n, L::Set(-2.12194440e-4f)));
+
+	// e^r = 1 + r + r^2 * P(r)
+	V p = L::Set(1.9875691500e-4f);
+	p = L::Add(L::Mul(p, r), L::Set(1.3981999507e-3f));
+	p = L::Add(L::Mul(p, r), L::Set(8.3334519073e-3f));
+	p = L::Add(L::Mul(p, r), L::Set(4.1665795894e-2f));
+	p = L::Add(L::Mul(p, r), L::Set(1.6666665459e-1f));
+	p = L::Add(L::Mul(p, r), L::Set(5.0000001201e-1f));
+	p = L::Add(L::Add(L::Mul(p, L::Mul(r, r)), r), L::Set(1.0f));
+
+	// e^x = 2^n * e^r
+	return L::Mul(p, L::Pow2(n));
+}
+
+// Compute the sigmoid function 1 / (1 + e^(-x * slope)) for a vector.
+template <class L>
+inline typename L::Type SigmoidLanes(typename L::Type x, typename L::Type negSlope)
+{
+	typename L::Type one = L::Set(1.0f);
+	return L::Div(one, L::Add(one, ExpLanes<L>(L::Mul(x, negSlope))));
+}
+
+// Approximate the sigmoid function for a vector as 0.5 + 0.5 * tanh(x / 2),
+// with tanh from a rational function (Lambert's continued fraction, cut off
+// at the 7th order). Accurate to about 5e-5, using only multiplies, adds and
+// one divide.
+template <class L>
+inline typename L::Type RationalSigmoidLanes(typename L::Type x, typename L::Type halfSlope)
+{
+	typedef typename L::Type V;
+
+	V one = L::Set(1.0f);
+	V y = L::Min(L::Max(L::Mul(x, halfSlope), L::Set(-5.0f)), L::Set(5.0f));
+	V y2 = L::Mul(y, y);
+	V p = L::Add(L::Mul(L::Add(L::Mul(L::Add(y2, L::Set(378.0f)), y2),
+		L::Set(17325.0f)), y2), L::Set(135135.0f));
+	V q = L::Add(L::Mul(L::Add(L::Mul(L::Add(L::Mul(y2, L::Set(28.0f)),
+		L::Set(3150.0f)), y2), L::Set(62370.0f)), y2), L::Set(135135.0f));
+	V tanh = L::Min(L::Max(L::Div(L::Mul(y, p), q), L::Negate(one)), one);
+	V half = L::Set(0.5f);
+	return L::Add(half, L::Mul(half, tanh));
+}
+
+// Multiply a dense row-major weight matrix by a vector of activations. Rows
+// are processed four at a time so each activation vector is loaded once. The
+// stride must be a multiple of the lane width.
+template <class L>
+void DenseMultiply(const float* weights, unsigned int stride,
+	unsigned int numRows, const float* inputs, float* outSums)
+{
+	typedef typename L::Type V;
+
+	unsigned int row = 0;
+	for (; row + 4 <= numRows; row += 4)
+	{
+		const float* weights0 = weights + (row * stride);
+		const float* weights1 = weights0 + stride;
+		const float* weights2 = weights1 + stride;
+		const float* weights3 = weights2 + stride;
+		V sum0 = L::Set(0.0f);
+		V sum1 = L::Set(0.0f);
+		V sum2 = L::Set(0.0f);
+		V sum3 = L::Set(0.0f);
+
+		for (unsigned int i = 0; i < stride; i += L::WIDTH)
+		{
+			V x = L::Load(inputs + i);
+			sum0 = L::Add(sum0, L::Mul(L::Load(weights0 + i), x));
+			sum1 = L::Add(sum1, L::Mul(L::Load(weights1 + i), x));
+			sum2 = L::Add(sum2, L::Mul(L::Load(weights2 + i), x));
+			sum3 = L::Add(sum3, L::Mul(L::Load(weights3 + i), x));
+		}
+
+		outSums[row] = L::Sum(sum0);
+		outSums[row + 1] = L::Sum(sum1);
+		outSums[row + 2] = L::Sum(sum2);
+		outSums[row + 3] = L::Sum(sum3);
+	}
+
+	for (; row < numRows; ++row)
+	{
+		const float* rowWeights = weights + (row * stride);
+		V sum = L::Set(0.0f);
+		for (unsigned int i = 0; i < stride; i += L::WIDTH)
+			sum = L::Add(sum, L::Mul(L::Load(rowWeights + i), L::Load(inputs + i)));
+		outSums[row] = L::Sum(sum);
+	}
+}
+
+// The constants used by Hebbian learning, broadcast into vectors.
+template <class L>
+struct HebbianConstants
+{
+	typedef typename L::Type V;
+
+	V zero;
+	V half;
+	V one;
+	V maxWeight;
+	V halfMaxWeight;
+	V decayScale;
+	V maxInhibitory;
+	V minInhibitory;
+
+	HebbianConstants(float maxWeight, float decayRate) :
+		zero(L::Set(0.0f)),
+		half(L::Set(0.5f)),
+		one(L::Set(1.0f)),
+		maxWeight(L::Set(maxWeight)),
+		halfMaxWeight(L::Set(0.5f * maxWeight)),
+		decayScale(L::Set(1.0f - decayRate)),
+		maxInhibitory(L::Set(-1e-10f)),
+		minInhibitory(L::Set(-maxWeight))
+	{}
+};
+
+// Apply Hebbian learning to a vector of synapse weights, given the current
+// activations of the neurons they go to and the previous activations of
+// the neurons they come from. Weights whose learning rate is zero, or
+// where isEnabled is false, are returned unchanged. The arithmetic matches
+// the scalar update in the same order, without branches: the learning
+// rate's sign selects between the excitatory and inhibitory weight ranges.
+template <class L>
+inline typename L::Type HebbianLanes(typename L::Type oldWeight,
+	typename L::Type learningRate, typename L::Type currActivation,
+	typename L::Type prevActivation, typename L::Mask isEnabled,
+	const HebbianConstants<L>& c)
+{
+	typedef typename L::Type V;
+	typedef typename L::Mask M;
+
+	// Increase weight based on activation values of connected neurons.
+	V weight = L::Add(oldWeight, L::Mul(L::Mul(learningRate,
+		L::Sub(currActivation, c.half)), L::Sub(prevActivation, c.half)));
+
+	// Gradually decay synapse weights which are above half of max-weight.
+	V absWeight = L::Abs(weight);
+	V decayed = L::Mul(weight, L::Sub(c.one, L::Mul(c.decayScale,
+		L::Div(L::Sub(absWeight, c.halfMaxWeight), c.halfMaxWeight))));
+	weight = L::Select(L::Greater(absWeight, c.halfMaxWeight), decayed, weight);
+
+	// Clamp weight (sign depending on learning rate).
+	M isInhibitory = L::Less(learningRate, c.zero);
+	weight = L::Min(L::Max(weight,
+		L::Select(isInhibitory, c.minInhibitory, c.zero)),
+		L::Select(isInhibitory, c.maxInhibitory, c.maxWeight));
+
+	M isLearning = L::And(isEnabled, L::Greater(L::Abs(learningRate), c.zero));
+	return L::Select(isLearning, weight, oldWeight);
+}
+
+// The same update as HebbianLanes(), for all synapses enabled, with the
+// terms which are shared along a row of synapses computed up front: the
+// current activation minus a half, and the previous activations minus a
+// half. If T_IS_RECIPROCAL_EXACT, half the max weight must be a power of
+// two, so multiplying by its reciprocal gives the same results as dividing.
+template <class L, bool T_IS_RECIPROCAL_EXACT>
+inline typename L::Type HebbianCenteredLanes(typename L::Type oldWeight,
+	typename L::Type learningRate, typename L::Type centeredCurrActivation,
+	typename L::Type centeredPrevActivation, typename L::Type invHalfMaxWeight,
+	const HebbianConstants<L>& c)
+{
+	typedef typename L::Type V;
+	typedef typename L::Mask M;
+
+	V weight = L::Add(oldWeight, L::Mul(L::Mul(learningRate,
+		centeredCurrActivation), centeredPrevActivation));
+
+	V absWeight = L::Abs(weight);
+	V excess = L::Sub(absWeight, c.halfMaxWeight);
+	excess = (T_IS_RECIPROCAL_EXACT ? L::Mul(excess, invHalfMaxWeight) :
+		L::Div(excess, c.halfMaxWeight));
+	V decayed = L::Mul(weight, L::Sub(c.one, L::Mul(c.decayScale, excess)));
+	weight = L::Select(L::Greater(absWeight, c.halfMaxWeight), decayed, weight);
+
+	M isInhibitory = L::Less(learningRate, c.zero);
+	weight = L::Min(L::Max(weight,
+		L::Select(isInhibitory, c.minInhibitory, c.zero)),
+		L::Select(isInhibitory, c.maxInhibitory, c.maxWeight));
+
+	M isLearning = L::Greater(L::Abs(learningRate), c.zero);
+	return L::Select(isLearning, weight, oldWeight);
+}
+
+// Apply Hebbian learning to a row of synapses going to one neuron, given
+// the previous activations of the neurons they come from. The row doesn't
+// need to be padded.
+template <class L>
+void HebbianRow(float* weights, const float* learningRates,
+	const float* prevActivations, unsigned int count, float currActivation,
+	const HebbianConstants<L>& c, const HebbianConstants<ScalarLanes>& scalarConstants)
+{
+	typename L::Type curr = L::Set(currActivation);
+	typename L::Mask isEnabled = L::Greater(c.one, c.zero);
+	unsigned int i = 0;
+	for (; i + L::WIDTH <= count; i += L::WIDTH)
+	{
+		L::Store(weights + i, HebbianLanes<L>(L::Load(weights + i),
+			L::Load(learningRates + i), curr, L::Load(prevActivations + i),
+			isEnabled, c));
+	}
+	for (; i < count; ++i)
+	{
+		weights[i] = HebbianLanes<ScalarLanes>(weights[i], learningRates[i],
+			currActivation, prevActivations[i], true, scalarConstants);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Compact weight conversion - Converts rows of weights between floats and
+// the reduced precision formats. Counts must be a multiple of 8.
+//-----------------------------------------------------------------------------
+
+// Convert between a float and a 16-bit half precision float, rounding to
+// the nearest half. Rebiasing the exponent with a multiply handles denormals
+// without branches. Values beyond the half range aren't handled, as weights
+// are far smaller.
+inline unsigned short FloatToHalf(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(float));
+	unsigned int sign = (bits >> 16) & 0x8000;
+	bits &= 0x7FFFFFFF;
+	float magnitude;
+	memcpy(&magnitude, &bits, sizeof(float));
+	magnitude *= 1.925929944e-34f; // 2^-112
+	memcpy(&bits, &magnitude, sizeof(float));
+	bits += 0x0FFF + ((bits >> 13) & 1);
+	return (unsigned short) (sign | (bits >> 13));
+}
+
+inline float HalfToFloat(unsigned short half)
+{
+	unsigned int bits = (half & 0x7FFF) << 13;
+	float value;
+	memcpy(&value, &bits, sizeof(float));
+	value *= 5.192296859e+33f; // 2^112
+	memcpy(&bits, &value, sizeof(float));
+	bits |= (half & 0x8000) << 16;
+	memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+#if defined(SEAL_SIMD_SSE2)
+
+inline void DecodeHalfRow(const unsigned short* halves, unsigned int count, float* outValues)
+{
+	const __m128i magnitudeMask = _mm_set1_epi32(0x7FFF);
+	const __m128i signMask = _mm_set1_epi32(0x8000);
+	const __m128 rebias = _mm_set1_ps(5.192296859e+33f);
+	const __m128i zero = _mm_setzero_si128();
+	for (unsigned int i = 0; i < count; i += 8)
+	{
+		__m128i h = _mm_loadu_si128((const __m128i*) (halves + i));
+		__m128i parts[2] = { _mm_unpacklo_epi16(h, zero), _mm_unpackhi_epi16(h, zero) };
+		for (unsigned int j = 0; j < 2; ++j)
+		{
+			__m128 value = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(
+				_mm_and_si128(parts[j], magnitudeMask), 13)), rebias);
+			__m128i sign = _mm_slli_epi32(_mm_and_si128(parts[j], signMask), 16);
+			_mm_storeu_ps(outValues + i + (j * 4), _mm_or_ps(value, _mm_castsi128_ps(sign)));
+		}
+	}
+}
+
+inline void EncodeHalfRow(const float* values, unsigned int count, unsigned short* outHalves)
+{
+	const __m128 rebias = _mm_set1_ps(1.925929944e-34f);
+	const __m128i absMask = _mm_set1_epi32(0x7FFFFFFF);
+	const __m128i signMask = _mm_set1_epi32(0x8000);
+	const __m128i roundBias = _mm_set1_epi32(0x0FFF);
+	const __m128i one = _mm_set1_epi32(1);
+	for (unsigned int i = 0; i < count; i += 8)
+	{
+		__m128i parts[2];
+		for (unsigned int j = 0; j < 2; ++j)
+		{
+			__m128i bits = _mm_castps_si128(_mm_loadu_ps(values + i + (j * 4)));
+			__m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), signMask);
+			bits = _mm_castps_si128(_mm_mul_ps(_mm_castsi128_ps(
+				_mm_and_si128(bits, absMask)), rebias));
+			bits = _mm_add_epi32(bits, _mm_add_epi32(roundBias,
+				_mm_and_si128(_mm_srli_epi32(bits, 13), one)));
+			bits = _mm_or_si128(sign, _mm_srli_epi32(bits, 13));
+
+			// Sign-extend the halves so they pack without saturating.
+			parts[j] = _mm_srai_epi32(_mm_slli_epi32(bits, 16), 16);
+		}
+		_mm_storeu_si128((__m128i*) (outHalves + i), _mm_packs_epi32(parts[0], parts[1]));
+	}
+}
+
+inline void DecodeInt8Row(const signed char* values, unsigned int count, float scale, float* outValues)
+{
+	const __m128 scales = _mm_set1_ps(scale);
+	for (unsigned int i = 0; i < count; i += 8)
+	{
+		// Sign-extend the bytes to 32 bits by unpacking them into the high
+		// bytes, then shifting them down.
+		__m128i bytes = _mm_loadl_epi64((const __m128i*) (values + i));
+		__m128i words = _mm_unpacklo_epi8(bytes, bytes);
+		__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 24);
+		__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 24);
+		_mm_storeu_ps(outValues + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scales));
+		_mm_storeu_ps(outValues + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scales));
+	}
+}
+
+inline void EncodeInt8Row(const float* values, unsigned int count, float invScale, signed char* outValues)
+{
+	const __m128 invScales = _mm_set1_ps(invScale);
+	for (unsigned int i = 0; i < count; i += 8)
+	{
+		__m128i low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(values + i), invScales));
+		__m128i high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(values + i + 4), invScales));
+		__m128i words = _mm_packs_epi32(low, high);
+		_mm_storel_epi64((__m128i*) (outValues + i), _mm_packs_epi16(words, words));
+	}
+}
+
+#else
+
+inline void DecodeHalfRow(const unsigned short* halves, unsigned int count, float* outValues)
+{
+	for (unsigned int i = 0; i < count; ++i)
+		outValues[i] = HalfToFloat(halves[i]);
+}
+
+inline void EncodeHalfRow(const float* values, unsigned int count, unsigned short* outHalves)
+{
+	for (unsigned int i = 0; i < count; ++i)
+		outHalves[i] = FloatToHalf(values[i]);
+}
+
+inline void DecodeInt8Row(const signed char* values, unsigned int count, float scale, float* outValues)
+{
+	for (unsigned int i = 0; i < count; ++i)
+		outValues[i] = values[i] * scale;
+}
+
+inline void EncodeInt8Row(const float* values, unsigned int count, float invScale, signed char* outValues)
+{
+	for (unsigned int i = 0; i < count; ++i)
+		outValues[i] = (signed char) ScalarLanes::Round(values[i] * invScale);
+}
+
+#endif
+
+
+#endif // _BRAIN_KERNELS_H_
@@ -0,0 +1,97 @@
+#include "CellGrid.h"
+#include <math/MathLib.h>
+
+
+//-----------------------------------------------------------------------------
+// Constructor
+//-----------------------------------------------------------------------------
+
+CellGrid::CellGrid() :
+	m_isBuilt(false),
+	m_cellSize(1.0f),
+	m_invCellSize(1.0f),
+	m_padding(0.0f),
+	m_numCells(0),
+	m_queryCellCount(0),
+	m_queryObjectCount(0)
+{
+	m_dimensions[0] = 0;
+	m_dimensions[1] = 0;
+	m_dimensions[2] = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Operations
+//-----------------------------------------------------------------------------
+
+void CellGrid::Build(const AABB& bounds, float cellSize, float padding,
+	const std::vector<object_pointer>& objects)
+{
+	Clear();
+
+	m_bounds = bounds;
+	m_cellSize = cellSize;
+	m_invCellSize = 1.0f / cellSize;
+	m_padding = padding;
+
+	// Determine the number of cells along each axis.
+	Vector3f size = bounds.GetSize();
+	m_numCells = 1;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		m_dimensions[axis] = Math::Max(1, (int) Math::Ceil(size[axis] * m_invCellSize));
+		m_numCells *= (unsigned int) m_dimensions[axis];
+	}
+
+	// Count the number of objects in each cell.
+	m_cellStart.assign(m_numCells + 1, 0);
+	m_objectCells.resize(objects.size());
+	for (unsigned int i = 0; i < objects.size(); ++i)
+	{
+		const Vector3f& position = objects[i]->GetPosition();
+		unsigned int cellIndex = (unsigned int)
+			(((GetCellCoordinate(position.z, 2) * m_dimensions[1]) +
+			GetCellCoordinate(position.y, 1)) * m_dimensions[0] +
+			GetCellCoordinate(position.x, 0));
+		m_objectCells[i] = cellIndex;
+		m_cellStart[cellIndex + 1]++;
+	}
+
+	// Convert the counts into list offsets.
+	for (unsigned int i = 0; i < m_numCells; ++i)
+		m_cellStart[i + 1] += m_cellStart[i];
+
+	// Place each object into its cell's list, keeping their original order.
+	m_cellObjects.resize(objects.size());
+	std::vector<unsigned int> cursor(m_cellStart.begin(), m_cellStart.end() - 1);
+	for (unsigned int i = 0; i < objects.size(); ++i)
+		m_cellObjects[cursor[m_objectCells[i]]++] = objects[i];
+
+	m_isBuilt = true;
+}
+
+void CellGrid::InsertObject(object_pointer object)
+{
+	if (m_isBuilt)
+		m_lateObjects.push_back(object);
+}
+
+void CellGrid::Clear()
+{
+	m_isBuilt = false;
+	m_cellStart.assign(m_numCells + 1, 0);
+	m_cellObjects.clear();
+	m_lateObjects.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+int CellGrid::GetCellCoordinate(float position, int axis) const
+{
+	int coord = (int) Math::Floor((position - m_bounds.mins[axis]) * m_invCellSize);
+	return Math::Clamp(coord, 0, m_dimensions[axis] - 1);
+}
@@ -0,0 +1,153 @@
+#ifndef _CELL_GRID_H_
+#define _CELL_GRID_H_
+
+#include "SimulationObject.h"
+#include <math/AABB.h>
+#include <math/Sphere.h>
+#include <math/Vector3f.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// CellGrid - Bins simulation objects into a uniform grid of cells once per
+//            tick. Cells are sized so that a vision query only needs to
+//            concatenate the lists of a handful of neighbouring cells,
+//            rather than traversing the oct-tree. Each cell's objects are
+//            stored contiguously, in the order they were binned.
+//
+//            Objects may move after the grid is built, so queries are
+//            inflated by a padding distance to account for this. Objects
+//            spawned after the grid is built are kept in a separate list
+//            that is checked by every query.
+//-----------------------------------------------------------------------------
+class CellGrid
+{
+public:
+	typedef SimulationObject	object_type;
+	typedef object_type*		object_pointer;
+
+public:
+	//-------------------------------------------------------------------------
+	// Constructor
+
+	CellGrid();
+
+	//-------------------------------------------------------------------------
+	// Getters
+
+	inline bool IsBuilt() const { return m_isBuilt; }
+	inline float GetCellSize() const { return m_cellSize; }
+	inline unsigned int GetNumCells() const { return m_numCells; }
+
+	// Get the number of cells and candidate objects visited by the most
+	// recent query.
+	inline unsigned int GetQueryCellCount() const { return m_queryCellCount; }
+	inline unsigned int GetQueryObjectCount() const { return m_queryObjectCount; }
+
+	//-------------------------------------------------------------------------
+	// Operations
+
+	// Bin the given objects into cells of at least the given size, covering
+	// the given bounds. Queries are padded by the given distance to account
+	// for objects which move before the grid is next built.
+	void Build(const AABB& bounds, float cellSize, float padding,
+		const std::vector<object_pointer>& objects);
+
+	// Insert an object which was spawned after the grid was built.
+	void InsertObject(object_pointer object);
+
+	// Remove all objects from the grid.
+	void Clear();
+
+	// Query for objects which are touching the given sphere, This needs a
+	// callback function that takes a single SimulationObject* as a parameter.
+	template <class T_QueryCallback>
+	void Query(const Sphere& sphere, T_QueryCallback callback);
+
+
+private:
+	int GetCellCoordinate(float position, int axis) const;
+
+
+private:
+	bool			m_isBuilt;
+	AABB			m_bounds;
+	float			m_cellSize;
+	float			m_invCellSize;
+	float			m_padding;
+	int				m_dimensions[3];	// Number of cells along each axis
+	unsigned int	m_numCells;
+
+	std::vector<unsigned int>	m_cellStart;	// Offset of each cell's list (numCells + 1 entries)
+	std::vector<object_pointer>	m_cellObjects;	// Every cell's list, concatenated
+	std::vector<unsigned int>	m_objectCells;	// Scratch: the cell of each binned object
+	std::vector<object_pointer>	m_lateObjects;	// Objects spawned after building
+
+	unsigned int	m_queryCellCount;
+	unsigned int	m_queryObjectCount;
+};
+
+
+//-----------------------------------------------------------------------------
+// CellGrid template method definitions
+//-----------------------------------------------------------------------------
+
+// Query for objects which are touching the given sphere, This needs a
+// callback function that takes a single SimulationObject* as a parameter.
+template <class T_QueryCallback>
+void CellGrid::Query(const Sphere& sphere, T_QueryCallback callback)
+{
+	m_queryCellCount = 0;
+	m_queryObjectCount = 0;
+
+	// Find the range of cells touching the padded query sphere.
+	float reach = sphere.radius + m_padding;
+	int mins[3];
+	int maxs[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		mins[axis] = GetCellCoordinate(sphere.position[axis] - reach, axis);
+		maxs[axis] = GetCellCoordinate(sphere.position[axis] + reach, axis);
+	}
+
+	// Concatenate the lists of those cells.
+	for (int z = mins[2]; z <= maxs[2]; ++z)
+	{
+		for (int y = mins[1]; y <= maxs[1]; ++y)
+		{
+			unsigned int rowIndex = (unsigned int)
+				(((z * m_dimensions[1]) + y) * m_dimensions[0]);
+			unsigned int begin = m_cellStart[rowIndex + mins[0]];
+			unsigned int end = m_cellStart[rowIndex + maxs[0] + 1];
+			m_queryCellCount += (unsigned int) (maxs[0] - mins[0] + 1);
+			m_queryObjectCount += end - begin;
+
+			for (unsigned int i = begin; i < end; ++i)
+			{
+				SimulationObject* object = m_cellObjects[i];
+				Sphere objectSphere(object->GetPosition(), object->GetRadius());
+
+				if (sphere.Intersects(objectSphere) && !object->IsDestroyed())
+				{
+					callback(object);
+				}
+			}
+		}
+	}
+
+	// Check the objects spawned since the grid was built.
+	m_queryObjectCount += m_lateObjects.size();
+	for (unsigned int i = 0; i < m_lateObjects.size(); ++i)
+	{
+		SimulationObject* object = m_lateObjects[i];
+		Sphere objectSphere(object->GetPosition(), object->GetRadius());
+
+		if (sphere.Intersects(objectSphere) && !object->IsDestroyed())
+		{
+			callback(object);
+		}
+	}
+}
+
+
+#endif // _CELL_GRID_H_
@@ -0,0 +1,152 @@
+#include "DenseBrainKernels.h"
+#include "BrainKernels.h"
+#include <string.h>
+
+
+//-----------------------------------------------------------------------------
+// FixedDenseBrainKernel - The dense update for a fixed padded neuron count.
+//-----------------------------------------------------------------------------
+template <unsigned int T_STRIDE>
+class FixedDenseBrainKernel
+{
+public:
+	typedef BrainLanes L;
+	typedef L::Type V;
+
+	static const unsigned int NUM_VECTORS = T_STRIDE / L::WIDTH;
+
+	static void Update(const DenseBrainKernelParams& params)
+	{
+		const unsigned int numRows = params.numRows;
+		float* activations = params.activations;
+
+		// Load the previous activations once, for every row.
+		V inputs[NUM_VECTORS];
+		for (unsigned int i = 0; i < NUM_VECTORS; ++i)
+			inputs[i] = L::Load(params.prevActivations + (i * L::WIDTH));
+
+		// Sum up the input activations to each neuron multiplied by their
+		// synapse weights, in the same order as DenseMultiply(), then add in
+		// the bias terms.
+		unsigned int row = 0;
+		for (; row + 4 <= numRows; row += 4)
+		{
+			const float* weights0 = params.weights + (row * T_STRIDE);
+			const float* weights1 = weights0 + T_STRIDE;
+			const float* weights2 = weights1 + T_STRIDE;
+			const float* weights3 = weights2 + T_STRIDE;
+			V sum0 = L::Set(0.0f);
+			V sum1 = L::Set(0.0f);
+			V sum2 = L::Set(0.0f);
+			V sum3 = L::Set(0.0f);
+			for (unsigned int i = 0; i < NUM_VECTORS; ++i)
+			{
+				unsigned int offset = i * L::WIDTH;
+				sum0 = L::Add(sum0, L::Mul(L::Load(weights0 + offset), inputs[i]));
+				sum1 = L::Add(sum1, L::Mul(L::Load(weights1 + offset), inputs[i]));
+				sum2 = L::Add(sum2, L::Mul(L::Load(weights2 + offset), inputs[i]));
+				sum3 = L::Add(sum3, L::Mul(L::Load(weights3 + offset), inputs[i]));
+			}
+			activations[row] = L::Sum(sum0);
+			activations[row + 1] = L::Sum(sum1);
+			activations[row + 2] = L::Sum(sum2);
+			activations[row + 3] = L::Sum(sum3);
+		}
+		for (; row < numRows; ++row)
+		{
+			const float* rowWeights = params.weights + (row * T_STRIDE);
+			V sum = L::Set(0.0f);
+			for (unsigned int i = 0; i < NUM_VECTORS; ++i)
+				sum = L::Add(sum, L::Mul(L::Load(rowWeights + (i * L::WIDTH)), inputs[i]));
+			activations[row] = L::Sum(sum);
+		}
+		for (row = 0; row < numRows; ++row)
+			activations[row] += params.rowNeurons[row].bias;
+
+		// Apply the sigmoid function to the resulting activation sums.
+		SigmoidFunctions::Apply(params.sigmoidFunction, activations, numRows, 1.0f);
+
+		if (!params.isLearning)
+			return;
+
+		// Dividing by half the max weight is the same as multiplying by its
+		// reciprocal when it is a power of two, as it is by default.
+		float halfMaxWeight = 0.5f * params.maxWeight;
+		float invHalfMaxWeight = 1.0f / halfMaxWeight;
+		if (halfMaxWeight > 0.0f && invHalfMaxWeight * halfMaxWeight == 1.0f &&
+			IsPowerOfTwo(halfMaxWeight))
+			Learn<true>(params, inputs, invHalfMaxWeight);
+		else
+			Learn<false>(params, inputs, invHalfMaxWeight);
+	}
+
+private:
+	static bool IsPowerOfTwo(float x)
+	{
+		unsigned int bits;
+		memcpy(&bits, &x, sizeof(float));
+		return ((bits & 0x007FFFFF) == 0 && (bits & 0x7F800000) != 0);
+	}
+
+	// Update Hebbian learning for all synapses. The padding columns have no
+	// learning rate, so they are left as zero.
+	template <bool T_IS_RECIPROCAL_EXACT>
+	static void Learn(const DenseBrainKernelParams& params,
+		const V* inputs, float invHalfMaxWeight)
+	{
+		HebbianConstants<L> constants(params.maxWeight, params.decayRate);
+		V invHalfMaxWeights = L::Set(invHalfMaxWeight);
+		V centeredInputs[NUM_VECTORS];
+		for (unsigned int i = 0; i < NUM_VECTORS; ++i)
+			centeredInputs[i] = L::Sub(inputs[i], constants.half);
+
+		for (unsigned int row = 0; row < params.numRows; ++row)
+		{
+			float* rowWeights = params.weights + (row * T_STRIDE);
+			const float* rowLearningRates = params.learningRates + (row * T_STRIDE);
+			V centeredCurr = L::Sub(L::Set(params.activations[row]), constants.half);
+			for (unsigned int i = 0; i < NUM_VECTORS; ++i)
+			{
+				unsigned int offset = i * L::WIDTH;
+				L::Store(rowWeights + offset, HebbianCenteredLanes<L, T_IS_RECIPROCAL_EXACT>(
+					L::Load(rowWeights + offset), L::Load(rowLearningRates + offset),
+					centeredCurr, centeredInputs[i], invHalfMaxWeights, constants));
+			}
+		}
+	}
+};
+
+
+//-----------------------------------------------------------------------------
+// Kernel selection
+//-----------------------------------------------------------------------------
+
+// The kernel for each padded neuron count, indexed by the count divided by
+// the padding.
+static const DenseBrainKernels::UpdateFunc FIXED_DENSE_BRAIN_KERNELS[] =
+{
+	nullptr,
+	&FixedDenseBrainKernel<8>::Update,
+	&FixedDenseBrainKernel<16>::Update,
+	&FixedDenseBrainKernel<24>::Update,
+	&FixedDenseBrainKernel<32>::Update,
+	&FixedDenseBrainKernel<40>::Update,
+	&FixedDenseBrainKernel<48>::Update,
+	&FixedDenseBrainKernel<56>::Update,
+	&FixedDenseBrainKernel<64>::Update,
+	&FixedDenseBrainKernel<72>::Update,
+	&FixedDenseBrainKernel<80>::Update,
+	&FixedDenseBrainKernel<88>::Update,
+	&FixedDenseBrainKernel<96>::Update,
+	&FixedDenseBrainKernel<104>::Update,
+	&FixedDenseBrainKernel<112>::Update,
+	&FixedDenseBrainKernel<120>::Update,
+	&FixedDenseBrainKernel<DenseBrainKernels::MAX_STRIDE>::Update,
+};
+
+DenseBrainKernels::UpdateFunc DenseBrainKernels::Select(unsigned int stride)
+{
+	if (stride == 0 || stride > MAX_STRIDE || stride % BRAIN_PADDING != 0)
+		return nullptr;
+	return FIXED_DENSE_BRAIN_KERNELS[stride / BRAIN_PADDING];
+}
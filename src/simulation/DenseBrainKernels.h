@@ -0,0 +1,50 @@
+#ifndef _DENSE_BRAIN_KERNELS_H_
+#define _DENSE_BRAIN_KERNELS_H_
+
+#include "Brain.h"
+
+
+//-----------------------------------------------------------------------------
+// DenseBrainKernelParams - The arrays and settings of a dense brain update.
+//-----------------------------------------------------------------------------
+struct DenseBrainKernelParams
+{
+	float*			weights; // Row-major, with rows padded to the kernel's stride.
+	const float*	learningRates;
+	const Neuron*	rowNeurons; // The neuron of each row, for its bias.
+	unsigned int	numRows;
+	const float*	prevActivations; // Padded to the kernel's stride.
+	float*			activations; // The row neurons' new activations.
+	SigmoidFunction	sigmoidFunction;
+	float			maxWeight;
+	float			decayRate;
+	bool			isLearning;
+};
+
+
+//-----------------------------------------------------------------------------
+// DenseBrainKernels - Updates dense brains, with the weights, the sigmoid
+//                     function and Hebbian learning. Kernels are
+//                     specialized at compile time for the padded number of
+//                     neurons, so the loops over a row are fully unrolled
+//                     and the previous activations stay in registers for
+//                     every row. Rows are summed four at a time. A kernel is
+//                     selected once when a brain is grown, and gives the
+//                     same results as the generic dense update.
+//-----------------------------------------------------------------------------
+class DenseBrainKernels
+{
+public:
+	typedef void (*UpdateFunc)(const DenseBrainKernelParams& params);
+
+	// The largest padded neuron count with a specialized kernel. Brains
+	// with more neurons use the generic dense update.
+	static const unsigned int MAX_STRIDE = 128;
+
+	// Select the kernel for the given padded neuron count, or return
+	// nullptr if there is no specialized kernel for it.
+	static UpdateFunc Select(unsigned int stride);
+};
+
+
+#endif // _DENSE_BRAIN_KERNELS_H_
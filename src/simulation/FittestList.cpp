@@ -1,26 +1,28 @@
 #include "FittestList.h"
 #include <simulation/Agent.h>
+#include <math/MathLib.h>
 #include <assert.h>
 
 
 FittestList::FittestList() :
 	m_capacity(0),
 	m_size(0),
-	m_fittest(nullptr)
+	m_fittest(nullptr),
+	m_heap(nullptr),
+	m_fitnessSums(nullptr),
+	m_totalFitness(0.0)
 {
 }
 
 FittestList::FittestList(int capacity) :
-	m_capacity(capacity),
-	m_size(0)
+	m_capacity(0),
+	m_size(0),
+	m_fittest(nullptr),
+	m_heap(nullptr),
+	m_fitnessSums(nullptr),
+	m_totalFitness(0.0)
 {
-	m_fittest = new Fittest[m_capacity];
-	for (int i = 0; i < m_capacity; i++)
-	{
-		m_fittest[i].fitness = 0.0f;
-		m_fittest[i].agentId = -1;
-		m_fittest[i].genome = nullptr;
-	}
+	Reset(capacity);
 }
 
 FittestList::~FittestList()
@@ -28,15 +30,23 @@ FittestList::~FittestList()
 	Clear();
 	delete [] m_fittest;
 	m_fittest = nullptr;
+	delete [] m_heap;
+	m_heap = nullptr;
+	delete [] m_fitnessSums;
+	m_fitnessSums = nullptr;
 }
 
 void FittestList::Reset(int capacity)
 {
 	Clear();
 	delete [] m_fittest;
+	delete [] m_heap;
+	delete [] m_fitnessSums;
 
 	m_capacity = capacity;
 	m_fittest = new Fittest[m_capacity];
+	m_heap = new int[m_capacity];
+	m_fitnessSums = new double[m_capacity + 1];
 
 	for (int i = 0; i < m_capacity; i++)
 	{
@@ -44,6 +54,9 @@ void FittestList::Reset(int capacity)
 		m_fittest[i].agentId = -1;
 		m_fittest[i].genome = nullptr;
 	}
+	for (int i = 0; i <= m_capacity; i++)
+		m_fitnessSums[i] = 0.0;
+	m_totalFitness = 0.0;
 }
 
 int FittestList::GetCapacity() const
@@ -70,58 +83,74 @@ void FittestList::Clear()
 {
 	for (int i = 0; i < m_size; i++)
 	{
-		delete m_fittest[i].genome;
+		m_fittest[i].genome->Release();
 		m_fittest[i].genome = nullptr;
+		m_fittest[i].fitness = 0.0f;
+		m_fittest[i].agentId = -1;
 	}
+	if (m_fitnessSums != nullptr)
+	{
+		for (int i = 0; i <= m_capacity; i++)
+			m_fitnessSums[i] = 0.0;
+	}
+	m_totalFitness = 0.0;
 	m_size = 0;
 }
 
 void FittestList::Update(Agent* agent, float fitness)
 {
-	if (!IsFull() || fitness > m_fittest[m_size - 1].fitness)
+	int slot;
+	bool isNewSlot = !IsFull();
+	if (isNewSlot)
 	{
-		// Determine the rank of the new agent.
-		int rank = 0;
-		for (int i = 0; i < m_size; i++)
-		{
-			if (fitness > m_fittest[i].fitness)
-			{
-				rank = i;
-				break;
-			}
-		}
-		
-		// Delete the lowest-ranked genome if were full.
-		if (IsFull())
-		{
-			delete m_fittest[m_size - 1].genome;
-			m_fittest[m_size - 1].genome = nullptr;
-		}
-		else
-		{
-			m_size++;
-		}
-
-		// Shift other agents up (down in rank).
-		for (int i = m_size - 1; i > rank; i--)
-			m_fittest[i] = m_fittest[i - 1];
-		
-		// Insert the new genome at its appropriate rank.
-		m_fittest[rank].fitness = fitness;
-		m_fittest[rank].agentId	= agent->GetId();
-		m_fittest[rank].genome = new Genome(*agent->GetGenome());
+		// Fill the next empty slot, and add it to the heap.
+		slot = m_size;
+		m_heap[m_size] = slot;
+		m_size++;
+	}
+	else if (m_capacity > 0 && fitness > m_fittest[m_heap[0]].fitness)
+	{
+		// Replace the least fit genome.
+		slot = m_heap[0];
+		m_fittest[slot].genome->Release();
+		m_fittest[slot].genome = nullptr;
+		AddFitnessSum(slot, -Math::Max(m_fittest[slot].fitness, 0.0f));
 	}
+	else
+	{
+		return;
+	}
+
+	// Insert the new genome into the slot.
+	m_fittest[slot].fitness = fitness;
+	m_fittest[slot].agentId	= agent->GetId();
+	m_fittest[slot].genome = agent->GetGenome();
+	m_fittest[slot].genome->AddReference();
+	AddFitnessSum(slot, Math::Max(fitness, 0.0f));
+
+	// Restore the heap order. A new slot is at the bottom of the heap, and
+	// a replaced one is at the top.
+	if (isNewSlot)
+		SiftUp(m_size - 1);
+	else
+		SiftDown(0);
 }
 
-Fittest* FittestList::GetByRank(int rank)
+Fittest* FittestList::GetBySlot(int slot)
 {
-	assert(rank >= 0 && rank < m_size);
-	return &m_fittest[rank];
+	assert(slot >= 0 && slot < m_size);
+	return &m_fittest[slot];
+}
+
+Fittest* FittestList::GetLeastFit()
+{
+	assert(m_size > 0);
+	return &m_fittest[m_heap[0]];
 }
 
 
 
-Genome* FittestList::PickOneRandom(RNG& random)
+const Genome* FittestList::PickOneRandom(RNG& random)
 {
 	if (m_size == 0)
 		return nullptr;
@@ -129,54 +158,42 @@ Genome* FittestList::PickOneRandom(RNG& random)
 	return m_fittest[index].genome;
 }
 
-Genome* FittestList::PickOneRandomWeighted(RNG& random)
+const Genome* FittestList::PickOneRandomWeighted(RNG& random)
 {
 	if (m_size == 0)
 		return nullptr;
 
-	// Sum up the total fitness of all agents in the list.
-	float totalFitness = 0.0f;
-	for (int i = 0; i < m_size; ++i)
-		m_fittest[i].fitness += totalFitness;
-
 	// If all agents are equally weak, pick any one.
-	if (totalFitness == 0.0f)
+	if (m_totalFitness <= 0.0)
 		return PickOneRandom(random);
 
-	// Otherwise, pick a random agent weighted by fitness.
-	float select = random.NextFloat(0.0f, totalFitness);
-	float counter = 0.0f;
-	for (int i = 0; i < m_size; ++i)
-	{
-		counter += m_fittest[i].fitness;
-		if (select <= counter)
-			return m_fittest[i].genome;
-	}
-
-	// This shouldn't happen, but handle it anyways.
-	return PickOneRandom(random);
+	// Otherwise, pick a random agent weighted by fitness. The random number
+	// has 30 bits of precision, so large lists are sampled finely enough.
+	double range = RNG::RANDOM_MAX + 1.0;
+	double uniform = ((random.NextInt() * range) + random.NextInt() + 0.5) / (range * range);
+	return m_fittest[FindSlotByFitnessSum(uniform * m_totalFitness)].genome;
 }
 
 void FittestList::PickTwoTournamentSelection(RNG& random,
-	int tournamentSize, Genome*& outFirst, Genome*& outSecond)
+	int tournamentSize, const Genome*& outFirst, const Genome*& outSecond)
 {
 	assert(m_size >= 2);
-	
-	// Pick the first agent.
-	int firstIndex = m_size - 1;
-	for (int i = 0; i < tournamentSize; ++i)
+
+	// Pick the first agent, as the fittest of a few random ones.
+	int firstIndex = random.NextInt(0, m_size);
+	for (int i = 1; i < tournamentSize; ++i)
 	{
 		int r = random.NextInt(0, m_size);
-		if (firstIndex > r)
+		if (m_fittest[r].fitness > m_fittest[firstIndex].fitness)
 			firstIndex = r;
 	}
 
-	// Pick the second agent.
-	int secondIndex = m_size - 1;
-	for (int i = 0; i < tournamentSize; ++i)
+	// Pick the second agent, from the others.
+	int secondIndex = (firstIndex + 1 + random.NextInt(0, m_size - 1)) % m_size;
+	for (int i = 1; i < tournamentSize; ++i)
 	{
 		int r = (firstIndex + 1 + random.NextInt(0, m_size - 1)) % m_size;
-		if (secondIndex > r)
+		if (m_fittest[r].fitness > m_fittest[secondIndex].fitness)
 			secondIndex = r;
 	}
 
@@ -184,3 +201,74 @@ void FittestList::PickTwoTournamentSelection(RNG& random,
 	outSecond = m_fittest[secondIndex].genome;
 }
 
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+void FittestList::SiftDown(int heapIndex)
+{
+	int slot = m_heap[heapIndex];
+	float fitness = m_fittest[slot].fitness;
+
+	while (true)
+	{
+		int child = (heapIndex * 2) + 1;
+		if (child >= m_size)
+			break;
+		if (child + 1 < m_size &&
+			m_fittest[m_heap[child + 1]].fitness < m_fittest[m_heap[child]].fitness)
+			child++;
+		if (m_fittest[m_heap[child]].fitness >= fitness)
+			break;
+		m_heap[heapIndex] = m_heap[child];
+		heapIndex = child;
+	}
+	m_heap[heapIndex] = slot;
+}
+
+void FittestList::SiftUp(int heapIndex)
+{
+	int slot = m_heap[heapIndex];
+	float fitness = m_fittest[slot].fitness;
+
+	while (heapIndex > 0)
+	{
+		int parent = (heapIndex - 1) / 2;
+		if (m_fittest[m_heap[parent]].fitness <= fitness)
+			break;
+		m_heap[heapIndex] = m_heap[parent];
+		heapIndex = parent;
+	}
+	m_heap[heapIndex] = slot;
+}
+
+void FittestList::AddFitnessSum(int slot, double amount)
+{
+	m_totalFitness += amount;
+	for (int i = slot + 1; i <= m_capacity; i += (i & -i))
+		m_fitnessSums[i] += amount;
+}
+
+// Find the first slot at which the sum of the fitness of all slots up to and
+// including it is more than the given sum.
+int FittestList::FindSlotByFitnessSum(double fitnessSum) const
+{
+	int step = 1;
+	while (step * 2 <= m_capacity)
+		step *= 2;
+
+	int slot = 0;
+	for (; step > 0; step /= 2)
+	{
+		if (slot + step <= m_capacity && m_fitnessSums[slot + step] <= fitnessSum)
+		{
+			slot += step;
+			fitnessSum -= m_fitnessSums[slot];
+		}
+	}
+
+	// A sum at or past the total picks the last slot.
+	return Math::Min(slot, m_size - 1);
+}
+
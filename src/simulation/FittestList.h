@@ -16,9 +16,9 @@ class Agent;
 //-----------------------------------------------------------------------------
 struct Fittest
 {
-	int		agentId;
-	float	fitness;
-	Genome*	genome;
+	int				agentId;
+	float			fitness;
+	const Genome*	genome; // A reference to the agent's shared genome.
 
 	Fittest() :
 		fitness(0.0f),
@@ -30,7 +30,13 @@ struct Fittest
 
 
 //-----------------------------------------------------------------------------
-// FittestList - Used to store a list of the most fit genomes.
+// FittestList - Used to store a list of the most fit genomes. Entries stay
+//               in the slot they were inserted into, while a min-heap of
+//               slots keeps track of the least fit entry, which is the one
+//               replaced by a fitter agent once the list is full. A Fenwick
+//               tree of the slots' fitness sums supports weighted picks.
+//               Updates and picks take O(log n) time, so large lists (in
+//               the thousands) stay cheap.
 //-----------------------------------------------------------------------------
 class FittestList
 {
@@ -55,8 +61,12 @@ public:
 	// Is the list full (does size equal capacity?)
 	bool IsFull() const;
 
-	// Get the fittest agent entry by rank, where rank 0 is the fittest.
-	Fittest* GetByRank(int rank);
+	// Get an entry by its slot, from 0 to size - 1. Slots are in the order
+	// entries were inserted, not in order of fitness.
+	Fittest* GetBySlot(int slot);
+
+	// Get the least fit entry, which is the next to be replaced.
+	Fittest* GetLeastFit();
 
 
 	//-------------------------------------------------------------------------
@@ -76,20 +86,30 @@ public:
 	// Fittest selection
 
 	// Pick a random genome.
-	Genome* PickOneRandom(RNG& random);
+	const Genome* PickOneRandom(RNG& random);
 
 	// Pick a random genome weighted by fitness.
-	Genome* PickOneRandomWeighted(RNG& random);
+	const Genome* PickOneRandomWeighted(RNG& random);
 
 	// Pick two random genomes using tournament selection.
 	void PickTwoTournamentSelection(RNG& random, int tournamentSize,
-		Genome*& outFirst, Genome*& outSecond);
+		const Genome*& outFirst, const Genome*& outSecond);
+
+
+private:
+	void SiftDown(int heapIndex);
+	void SiftUp(int heapIndex);
+	void AddFitnessSum(int slot, double amount);
+	int FindSlotByFitnessSum(double fitnessSum) const;
 
 
 private:
-	int			m_capacity;	// Maximum fittest genomes to store in the list.
-	int			m_size;		// Current number of genomes in the list.
-	Fittest*	m_fittest;	// Array of fittest genome entries.
+	int			m_capacity;		// Maximum fittest genomes to store in the list.
+	int			m_size;			// Current number of genomes in the list.
+	Fittest*	m_fittest;		// Array of fittest genome entries, by slot.
+	int*		m_heap;			// Min-heap of slots, with the least fit first.
+	double*		m_fitnessSums;	// Fenwick tree of the fitness of the slots.
+	double		m_totalFitness;	// Sum of the fitness of all entries.
 };
 
 
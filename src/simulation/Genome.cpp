@@ -1,20 +1,25 @@
 #include "Genome.h"
 #include <math/MathLib.h>
 #include <simulation/Brain.h>
+#include <simulation/BrainCache.h>
 #include <simulation/Simulation.h>
 #include <utilities/Random.h>
+#include <algorithm>
+#include <string.h>
 
 
 //-----------------------------------------------------------------------------
 // Constructor & destructor
 //-----------------------------------------------------------------------------
 
-Genome::Genome(const Genome& copy)
+Genome::Genome(const Genome& copy) :
+	m_referenceCount(1)
 {
 	m_genes = copy.m_genes;
 }
 
-Genome::Genome(const SpeciesConfig& config)
+Genome::Genome(const SpeciesConfig& config) :
+	m_referenceCount(1)
 {	
 	m_genes.resize(DetermineGenomeSize(config));
 }
@@ -24,6 +29,22 @@ Genome::~Genome()
 }
 
 
+//-----------------------------------------------------------------------------
+// Sharing
+//-----------------------------------------------------------------------------
+
+void Genome::AddReference() const
+{
+	m_referenceCount++;
+}
+
+void Genome::Release() const
+{
+	if (--m_referenceCount == 0)
+		delete this;
+}
+
+
 //-----------------------------------------------------------------------------
 // Genome operations
 //-----------------------------------------------------------------------------
@@ -43,11 +64,11 @@ int Genome::DetermineGenomeSize(const SpeciesConfig& config)
 		maxNeurons + (maxNeurons * (config.genes.maxInternalNeurons + numOutputNeurons));
 }
 
-Genome* Genome::SpawnChild(Genome* p1, Genome* p2, const SpeciesConfig& config, RNG& random)
+Genome* Genome::SpawnChild(const Genome* p1, const Genome* p2, const SpeciesConfig& config, RNG& random)
 {
 	// Given to the Agent class of the new agent to destroy when needed.
 	Genome* child = new Genome(config);
-	Genome* currentParent = p1;
+	const Genome* currentParent = p1;
 	const int GENOME_SIZE = (int)p1->m_genes.size();
 
 	// Get average mutation and crossover data from parents
@@ -73,6 +94,13 @@ Genome* Genome::SpawnChild(Genome* p1, Genome* p2, const SpeciesConfig& config,
 		++averageCrossoverPoints;
 	}
 
+	if (config.genes.useFastSpawning)
+	{
+		CrossOverSpans(child, p1, p2, averageCrossoverPoints, random);
+		MutateSkipping(child, averageMutationRate, random);
+		return child;
+	}
+
 	// Assign crossover points. (They apply once to physiological
 	// genes and then again to Neurological genes).
 	std::vector<int> crossoverPoints;
@@ -158,6 +186,108 @@ Genome* Genome::SpawnChild(Genome* p1, Genome* p2, const SpeciesConfig& config,
 	return child;
 }
 
+void Genome::CrossOverSpans(Genome* child, const Genome* p1, const Genome* p2,
+	int numCrossoverPoints, RNG& random)
+{
+	const int GENOME_SIZE = (int) child->m_genes.size();
+
+	// Choose the crossover points for the physiological genes and then for
+	// the neurological genes, each as a uniformly random set of distinct
+	// positions. Both segments must have room for them all.
+	int numPhysiologicalPoints = Math::Min(numCrossoverPoints, (int) GenePosition::NUERON_GENES_BEGIN);
+	int numNeurologicalPoints = Math::Min(numCrossoverPoints,
+		GENOME_SIZE - (int) GenePosition::NUERON_GENES_BEGIN);
+	std::vector<int> crossoverPoints;
+	crossoverPoints.reserve(numPhysiologicalPoints + numNeurologicalPoints);
+	ChooseCrossoverPoints(crossoverPoints, numPhysiologicalPoints,
+		0, GenePosition::NUERON_GENES_BEGIN, random);
+	ChooseCrossoverPoints(crossoverPoints, numNeurologicalPoints,
+		GenePosition::NUERON_GENES_BEGIN, GENOME_SIZE, random);
+	crossoverPoints.push_back(GENOME_SIZE);
+
+	// Copy the spans between crossover points, switching parents at each.
+	const Genome* currentParent = p1;
+	int spanBegin = 0;
+	for (unsigned int i = 0; i < crossoverPoints.size(); ++i)
+	{
+		int spanEnd = crossoverPoints[i];
+		if (spanEnd > spanBegin)
+		{
+			memcpy(child->m_genes.data() + spanBegin,
+				currentParent->m_genes.data() + spanBegin, spanEnd - spanBegin);
+		}
+		currentParent = (currentParent == p1 ? p2 : p1);
+		spanBegin = spanEnd;
+	}
+}
+
+void Genome::ChooseCrossoverPoints(std::vector<int>& points, int count,
+	int begin, int end, RNG& random)
+{
+	// Floyd's algorithm picks each set of distinct points with the same
+	// probability, without retrying on duplicates.
+	unsigned int first = points.size();
+	int range = end - begin;
+	for (int j = range - count; j < range; ++j)
+	{
+		int candidatePoint = begin + (random.NextInt() % (j + 1));
+		for (unsigned int k = first; k < points.size(); ++k)
+		{
+			if (points[k] == candidatePoint)
+			{
+				candidatePoint = begin + j;
+				break;
+			}
+		}
+		points.push_back(candidatePoint);
+	}
+	std::sort(points.begin() + first, points.end());
+}
+
+void Genome::MutateSkipping(Genome* child, float mutationRate, RNG& random)
+{
+	const int GENOME_SIZE = (int) child->m_genes.size();
+
+	// A gene mutates when a random float is within the mutation rate. Find
+	// the exact chance of that, from the number of random integers for which
+	// it happens.
+	int numMutatingInts = (int) (mutationRate * RNG::RANDOM_MAX) + 1;
+	while (numMutatingInts <= RNG::RANDOM_MAX &&
+		(float) numMutatingInts / (float) RNG::RANDOM_MAX <= mutationRate)
+	{
+		++numMutatingInts;
+	}
+	while (numMutatingInts > 0 &&
+		(float) (numMutatingInts - 1) / (float) RNG::RANDOM_MAX > mutationRate)
+	{
+		--numMutatingInts;
+	}
+	if (numMutatingInts <= 0)
+		return;
+	double mutationChance = numMutatingInts / (RNG::RANDOM_MAX + 1.0);
+	double logNoMutationChance = log(1.0 - mutationChance);
+
+	for (int i = 0; i < GENOME_SIZE; ++i)
+	{
+		// Skip over the genes which don't mutate. The number of them before
+		// the next mutation follows a geometric distribution, sampled from a
+		// uniform random number in (0, 1] with 30 bits of precision.
+		if (mutationChance < 1.0)
+		{
+			double uniform = ((random.NextInt() * (RNG::RANDOM_MAX + 1.0)) +
+				random.NextInt() + 1.0) / ((RNG::RANDOM_MAX + 1.0) * (RNG::RANDOM_MAX + 1.0));
+			double numSkipped = log(uniform) / logNoMutationChance;
+			if (numSkipped >= GENOME_SIZE - i)
+				return;
+			i += (int) numSkipped;
+		}
+
+		// XOR the gene with an empty byte that has a 1 randomly placed inside,
+		// effectively flipping a random bit.
+		child->m_genes[i] ^= (1u << random.NextInt() % 8);
+	}
+}
+
 
 //-----------------------------------------------------------------------------
 // Gene access
@@ -188,7 +318,52 @@ unsigned int Genome::GetGeneAsInt(unsigned int index, unsigned int minValue, uns
 // Neurogenetics
 //-----------------------------------------------------------------------------
 
-void Genome::GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesConfig)
+void Genome::GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesConfig,
+	BrainCache* cache) const
+{
+	BrainTopology grownTopology;
+	const BrainTopology* topology = &grownTopology;
+	if (cache != nullptr && cache->GetCapacity() > 0)
+		topology = cache->GetTopology(*this, speciesConfig);
+	else
+		GrowBrainTopology(grownTopology, speciesConfig);
+
+	//-------------------------------------------------------------------------
+	// Draw the random initial weights, in the order the synapses were grown.
+
+	std::vector<float> randomWeights(topology->isWeightPositive.size());
+	for (unsigned int i = 0; i < randomWeights.size(); ++i)
+	{
+		// Positive for excitatory, negative for inhibitory.
+		if (topology->isWeightPositive[i])
+			randomWeights[i] = random.NextFloat(1e-10f, speciesConfig.brain.initMaxWeight);
+		else
+			randomWeights[i] = random.NextFloat(-speciesConfig.brain.initMaxWeight, -1e-10f);
+	}
+
+	//-------------------------------------------------------------------------
+	// Initialize the brain with the topology and weights.
+
+	brain->CopyTopology(topology->brain);
+	for (unsigned int k = 0; k < brain->GetNumSynapses(); ++k)
+	{
+		int weightIndex = topology->synapseWeights[k];
+		if (weightIndex >= 0)
+		{
+			Synapse synapse = brain->GetSynapse(k);
+			brain->ConfigSynapse(k, randomWeights[weightIndex],
+				synapse.learningRate, synapse.neuronFrom, synapse.neuronTo);
+		}
+	}
+
+	brain->InitWeights(speciesConfig.brain.useDenseWeights,
+		(WeightPrecision) speciesConfig.brain.weightPrecision);
+	brain->SelectDenseKernel(speciesConfig.brain.useSpecializedKernels);
+	brain->SetLearningInterval(speciesConfig.brain.hebbianLearningInterval);
+	brain->SetSigmoidFunction((SigmoidFunction) speciesConfig.brain.sigmoidFunction);
+}
+
+void Genome::GrowBrainTopology(BrainTopology& topology, const SpeciesConfig& speciesConfig) const
 {
 	// Algorithm partially based on Polyworld:
 	// https://github.com/polyworld/polyworld
@@ -211,6 +386,7 @@ void Genome::GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesCo
 
 	std::vector<Neuron> neurons;
 	std::vector<Synapse> synapses;
+	std::vector<int> synapseWeights; // The random weight of each synapse, or -1.
 
 	//-------------------------------------------------------------------------
 	// Parse neuron bias genes.
@@ -245,19 +421,26 @@ void Genome::GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesCo
 		synapse.neuronFrom = i % maxNeurons;
 		synapse.neuronTo = (i / maxNeurons) + maxInputNeurons;
 
+		int weightIndex = -1;
+
 		if (speciesConfig.brain.useHebbianLearning)
 		{
-			// Randomize synapse weight.
+			// Randomize synapse weight, which is drawn when the brain is
+			// grown from this topology.
 			// Positive for excitatory, negative for inhibitory.
 			float gene = GetGeneAsFloat(NUERON_GENES_BEGIN + maxNeurons + i, 0.0f, 1.0f);
 			if (gene > 0.8f)
 			{
-				synapse.weight = random.NextFloat(1e-10f, speciesConfig.brain.initMaxWeight);
+				weightIndex = topology.isWeightPositive.size();
+				topology.isWeightPositive.push_back(true);
+				synapse.weight = 1e-10f;
 				synapse.learningRate = speciesConfig.brain.weightLearningRate;
 			}
 			else if (gene < 0.2f)
 			{
-				synapse.weight = random.NextFloat(-speciesConfig.brain.initMaxWeight, -1e-10f);
+				weightIndex = topology.isWeightPositive.size();
+				topology.isWeightPositive.push_back(false);
+				synapse.weight = -1e-10f;
 				synapse.learningRate = -speciesConfig.brain.weightLearningRate;
 			}
 			else
@@ -278,22 +461,45 @@ void Genome::GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesCo
 		{
 			synapse.weight = 0.0f;
 			synapse.learningRate = 0.0f;
+			weightIndex = -1;
 		}
 
 		synapses.push_back(synapse);
+		synapseWeights.push_back(weightIndex);
 	}
 
 	//-------------------------------------------------------------------------
 	// Initialize the brain with the neurons and synapses.
 
+	Brain* brain = &topology.brain;
 	brain->Initialize(neurons, synapses, 0.1f);
 	brain->SetNumInputNeurons(maxInputNeurons);
 	brain->SetNumOutputNeurons(numOutputNeurons);
 	brain->SetMaxWeight(speciesConfig.brain.maxWeight);
 	brain->SetDecayRate(speciesConfig.brain.weightDecayRate);
 
-	// TODO: prune the network of redundencies.
-	// If an input neuron is not used (vision neuron), then remove it.
-	// If an internal neuron has no incoming connections, then remove it.
-	// If an internal neuron has no outgoing connections, then remove it.
+	if (speciesConfig.brain.pruneNetwork)
+	{
+		// Sight inputs beyond each channel's resolution are never drawn to.
+		unsigned int resolutions[3] = { resRed, resGreen, resBlue };
+		unsigned int maxResolution = speciesConfig.genes.maxSightResolution;
+		std::vector<bool> isInputUsed(maxInputNeurons, true);
+		for (unsigned int i = SIGHT_INPUTS_BEGIN; i < maxInputNeurons; ++i)
+		{
+			unsigned int channel = (i - SIGHT_INPUTS_BEGIN) / (maxResolution * 2);
+			unsigned int pixel = (i - SIGHT_INPUTS_BEGIN) % maxResolution;
+			isInputUsed[i] = (pixel < resolutions[channel]);
+		}
+		brain->Prune(isInputUsed);
+	}
+
+	// Find the random weight of each remaining synapse. Pruning keeps the
+	// neuron indices, so they give each synapse's index as it was grown.
+	topology.synapseWeights.resize(brain->GetNumSynapses());
+	for (unsigned int k = 0; k < brain->GetNumSynapses(); ++k)
+	{
+		Synapse synapse = brain->GetSynapse(k);
+		topology.synapseWeights[k] = synapseWeights[
+			((synapse.neuronTo - maxInputNeurons) * maxNeurons) + synapse.neuronFrom];
+	}
 }
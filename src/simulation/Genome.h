@@ -1,12 +1,15 @@
 #ifndef _GENOME_H_
 #define _GENOME_H_
 
+#include <atomic>
 #include <vector>
 #include <simulation/SimulationConfig.h>
 #include <utilities/Random.h>
 
 class Simulation;
 class Brain;
+class BrainCache;
+struct BrainTopology;
 
 
 //-----------------------------------------------------------------------------
@@ -43,7 +46,10 @@ enum GenePosition
 
 //-----------------------------------------------------------------------------
 // Genome - A collection of single-byte genes, that can be crossed-over and
-//          mutated.
+//          mutated. A genome is left unchanged once an agent is born with
+//          it, so it can be shared between agents and the fittest lists.
+//          It is reference counted, starting with one reference for its
+//          creator, and deleted when its last reference is released.
 //-----------------------------------------------------------------------------
 class Genome
 {
@@ -54,6 +60,15 @@ public:
 	Genome(const Genome& copy);
 	Genome(const SpeciesConfig& config);
 	~Genome();
+
+	//-------------------------------------------------------------------------
+	// Sharing
+
+	// Add a reference to the genome, for a new owner sharing it.
+	void AddReference() const;
+
+	// Release a reference to the genome, deleting it if it was the last.
+	void Release() const;
 	
 	//-------------------------------------------------------------------------
 	// Genome operations
@@ -66,7 +81,7 @@ public:
 
 	// Create a child genome from two parent genomes,
 	// through crossover and mutation.
-	static Genome* SpawnChild(Genome* p1, Genome* p2,
+	static Genome* SpawnChild(const Genome* p1, const Genome* p2,
 		const SpeciesConfig& config, RNG& random);
 	
 	//-------------------------------------------------------------------------
@@ -84,12 +99,35 @@ public:
 	//-------------------------------------------------------------------------
 	// Neurogenetics
 
-	// Create a brain from the encoding in the neurological genes.
-	void GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesConfig);
+	// Create a brain from the encoding in the neurological genes. With a
+	// cache, the brain's topology is reused from an identical genome grown
+	// before, and only its random initial weights are drawn. Either way,
+	// the brain and the random numbers drawn are the same.
+	void GrowBrain(Brain* brain, RNG& random, const SpeciesConfig& speciesConfig,
+		BrainCache* cache = nullptr) const;
+
+	// Grow a brain's topology from the neurological genes, without drawing
+	// its random initial weights.
+	void GrowBrainTopology(BrainTopology& topology, const SpeciesConfig& speciesConfig) const;
+
+
+private:
+	// Copy the spans of the parents' genes between random crossover points
+	// into a child.
+	static void CrossOverSpans(Genome* child, const Genome* p1, const Genome* p2,
+		int numCrossoverPoints, RNG& random);
+
+	// Add a number of distinct random crossover points in a range, in order.
+	static void ChooseCrossoverPoints(std::vector<int>& points, int count,
+		int begin, int end, RNG& random);
+
+	// Mutate a child's genes, skipping straight to the next mutated gene.
+	static void MutateSkipping(Genome* child, float mutationRate, RNG& random);
 
 
 private:
 	std::vector<unsigned char> m_genes; // A gene is 1 byte. 0 = minimum value, 255 = maximum
+	mutable std::atomic<int> m_referenceCount;
 };
 
 
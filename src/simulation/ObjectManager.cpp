@@ -64,29 +64,28 @@ void ObjectManager::ClearObjects()
 {
 	m_idToObjectMap.clear();
 	m_octTree.Clear();
+	m_cellGrid.Clear();
 
 	// Delete all objects.
 	for (unsigned int i = 0; i < m_objects.size(); ++i)
 		delete m_objects[i];
 	m_objects.clear();
+	m_newbornAgents.clear();
 }
 
 void ObjectManager::UpdateObjects()
 {
-	// Update all objects.
-	for (unsigned int i = 0; i < m_objects.size(); ++i)
-	{
-		SimulationObject* object = m_objects[i];
-		if (object->m_isDestroyed)
-			continue;
+	// Agents spawned between ticks must be born before their brains are
+	// first updated.
+	PrepareNewborns();
 
-		object->Update();
-		CalcObjectDerivedData(object);
+	// Bin objects into cells once for all of this tick's vision queries.
+	BuildCellGrid();
 
-		// Update the object in the cct-tree since the
-		// object's position probably changed.
-		m_octTree.DynamicUpdate(object);
-	}
+	UpdateObjectsStaged();
+
+	// Agents born during this tick may be destroyed below.
+	PrepareNewborns();
 	
 	// Remove any destroyed objects.
 	for (unsigned int i = 0; i < m_objects.size(); ++i)
@@ -102,6 +101,176 @@ void ObjectManager::UpdateObjects()
 			i--;
 		}
 	}
+
+	// The cell lists are only valid for the tick they were built in.
+	m_cellGrid.Clear();
+}
+
+void ObjectManager::UpdateObjectsStaged()
+{
+	// Update all objects, stopping agents after they have sensed. Agents
+	// spawned during this pass haven't had their pre-birth cycles yet, so
+	// they first update on the next tick.
+	m_brainAgents.clear();
+	unsigned int numObjects = m_objects.size();
+	for (unsigned int i = 0; i < m_objects.size(); ++i)
+	{
+		SimulationObject* object = m_objects[i];
+		if (object->m_isDestroyed)
+			continue;
+
+		if (object->GetObjectType() == SimulationObjectType::AGENT)
+		{
+			if (i >= numObjects)
+				continue;
+			Agent* agent = (Agent*) object;
+			if (agent->UpdateSenses())
+			{
+				m_brainAgents.push_back(agent);
+				continue;
+			}
+		}
+		else
+		{
+			object->Update();
+		}
+
+		CalcObjectDerivedData(object);
+		m_octTree.DynamicUpdate(object);
+	}
+
+	UpdateBrains();
+
+	// Let the agents act on their updated brains.
+	for (unsigned int i = 0; i < m_brainAgents.size(); ++i)
+	{
+		Agent* agent = m_brainAgents[i];
+		if (agent->m_isDestroyed)
+			continue;
+
+		agent->UpdateActions();
+		CalcObjectDerivedData(agent);
+		m_octTree.DynamicUpdate(agent);
+	}
+	m_brainAgents.clear();
+}
+
+// Each agent's brain only reads its own inputs and only writes its own
+// activations and weights, so the brains are updated in parallel. Batched
+// brains are submitted in parallel too, then their batches are updated in
+// parallel across groups.
+void ObjectManager::UpdateBrains()
+{
+	ThreadPool& threadPool = m_simulation->GetThreadPool();
+
+	threadPool.ParallelFor(m_brainAgents.size(), BRAIN_AGENTS_PER_CHUNK,
+		[this](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			Agent* agent = m_brainAgents[i];
+			if (agent->m_isDestroyed)
+				continue;
+
+			agent->SetBrainInputs();
+			Brain* brain = agent->GetBrain();
+			if (brain->IsBatched())
+				brain->GetBatch()->Submit(brain);
+			else
+				brain->Update();
+		}
+	});
+
+	UpdateBrainBatches();
+}
+
+// Update all brains submitted to the brain batches, in parallel across
+// the groups of each batch.
+void ObjectManager::UpdateBrainBatches()
+{
+	ThreadPool& threadPool = m_simulation->GetThreadPool();
+
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		BrainBatch* batch = &m_brainBatches[i];
+		threadPool.ParallelFor(batch->GetNumGroups(), BRAIN_GROUPS_PER_CHUNK,
+			[batch](unsigned int begin, unsigned int end)
+		{
+			batch->UpdateGroups(begin, end - begin);
+		});
+	}
+}
+
+void ObjectManager::AddNewborn(Agent* agent)
+{
+	m_newbornAgents.push_back(agent);
+}
+
+// Each newborn's pre-birth cycles use its own random stream, so the
+// newborns can be prepared in parallel, and the results don't depend on
+// the number of threads.
+void ObjectManager::PrepareNewborns()
+{
+	if (m_newbornAgents.empty())
+		return;
+
+	ThreadPool& threadPool = m_simulation->GetThreadPool();
+	unsigned int numNewborns = m_newbornAgents.size();
+	unsigned int maxCycles = 0;
+
+	// Add the newborns' brains to their batches in the order they were
+	// born, so each brain gets the same slot for any number of threads.
+	m_newbornRandoms.resize(numNewborns);
+	for (unsigned int i = 0; i < numNewborns; ++i)
+	{
+		Agent* agent = m_newbornAgents[i];
+		const SpeciesConfig& config = m_simulation->GetAgentConfig(agent->GetSpecies());
+		Brain* brain = agent->GetBrain();
+
+		if (config.brain.useBatchedUpdate && brain->IsDense())
+			GetBrainBatch(agent->GetSpecies())->AddBrain(brain);
+		m_newbornRandoms[i].SetSeed(agent->GetRandomSeed(RANDOM_STREAM_PREBIRTH, 0));
+		maxCycles = Math::Max(maxCycles, (unsigned int) config.brain.numPrebirthCycles);
+	}
+
+	// Brains on their own run all of their cycles at once.
+	threadPool.ParallelFor(numNewborns, NEWBORNS_PER_CHUNK,
+		[this](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			Agent* agent = m_newbornAgents[i];
+			Brain* brain = agent->GetBrain();
+			if (!brain->IsBatched())
+			{
+				brain->PreBirth(m_simulation->GetAgentConfig(agent->GetSpecies()).
+					brain.numPrebirthCycles, m_newbornRandoms[i]);
+			}
+		}
+	});
+
+	// Batched brains run each cycle together in their batches.
+	for (unsigned int cycle = 0; cycle < maxCycles; ++cycle)
+	{
+		threadPool.ParallelFor(numNewborns, NEWBORNS_PER_CHUNK,
+			[this, cycle](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; ++i)
+			{
+				Agent* agent = m_newbornAgents[i];
+				Brain* brain = agent->GetBrain();
+				if (brain->IsBatched() && cycle < (unsigned int) m_simulation->
+					GetAgentConfig(agent->GetSpecies()).brain.numPrebirthCycles)
+				{
+					brain->RandomizeInputs(m_newbornRandoms[i]);
+					brain->GetBatch()->Submit(brain);
+				}
+			}
+		});
+		UpdateBrainBatches();
+	}
+
+	m_newbornAgents.clear();
 }
 
 void ObjectManager::SpawnObject(SimulationObject* object)
@@ -109,6 +278,7 @@ void ObjectManager::SpawnObject(SimulationObject* object)
 	m_objects.push_back(object);
 	m_idToObjectMap[m_objectIdCounter] = object;
 	m_octTree.InsertObject(object);
+	m_cellGrid.InsertObject(object);
 	
 	object->m_objectId = m_objectIdCounter;
 	m_objectIdCounter += 1;
@@ -326,3 +496,39 @@ void ObjectManager::CalcObjectDerivedData(SimulationObject* object)
 		Matrix4f::CreateRotation(object->m_orientation);
 }
 
+
+void ObjectManager::BuildCellGrid()
+{
+	const SimulationConfig& config = m_simulation->GetConfig();
+
+	// Size the cells to the largest sight distance of the species which use
+	// cell lists, so a vision query only touches neighbouring cells.
+	bool useCellLists = false;
+	float cellSize = 0.0f;
+	float maxMoveSpeed = 0.0f;
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		const SpeciesConfig& speciesConfig = config.species[i];
+		if (speciesConfig.vision.useCellLists)
+		{
+			useCellLists = true;
+			cellSize = Math::Max(cellSize, speciesConfig.genes.maxSightDistance);
+		}
+		maxMoveSpeed = Math::Max(maxMoveSpeed, Math::Max(
+			speciesConfig.agent.maxMoveSpeedAtMinStrength,
+			speciesConfig.agent.maxMoveSpeedAtMaxStrength));
+	}
+	if (!useCellLists)
+		return;
+
+	// Objects move by at most their move speed during the tick, and can be
+	// pushed apart by collisions, so pad queries by this amount. The padding
+	// also covers the radius of objects touching the query sphere.
+	float largestRadius = 0.0f;
+	for (unsigned int i = 0; i < m_objects.size(); ++i)
+		largestRadius = Math::Max(largestRadius, m_objects[i]->GetRadius());
+	float padding = (largestRadius * 2.0f) + maxMoveSpeed;
+
+	m_cellGrid.Build(m_octTree.GetBounds(), cellSize + padding,
+		padding, m_objects);
+}
@@ -3,10 +3,12 @@
 
 #include <math/Vector3f.h>
 #include <simulation/OctTree.h>
+#include <simulation/CellGrid.h>
 #include <simulation/SimulationObject.h>
 #include <simulation/Agent.h>
 #include <simulation/Plant.h>
 #include <simulation/Offshoot.h>
+#include <simulation/BrainBatch.h>
 #include <vector>
 
 class Simulation;
@@ -38,9 +40,13 @@ public:
 	inline Simulation* GetSimulation() { return m_simulation; }
 
 	inline OctTree* GetOctTree() { return &m_octTree; }
+	inline CellGrid* GetCellGrid() { return &m_cellGrid; }
 
 	inline unsigned int GetNumObjects() const { return m_objects.size(); }
 
+	// The batch which updates the dense brains of a species together.
+	inline BrainBatch* GetBrainBatch(Species species) { return &m_brainBatches[species]; }
+
 	// Query an object by its object ID.
 	SimulationObject* GetObjectById(int objectId);
 
@@ -55,6 +61,14 @@ public:
 	// Clear (delete) all objects from the simulation.
 	void ClearObjects();
 	
+	// Queue a newly spawned agent to have its brain's pre-birth cycles run
+	// by the next call to PrepareNewborns().
+	void AddNewborn(Agent* agent);
+
+	// Run the pre-birth cycles of all queued newborn agents together, and
+	// let their species' brain batches take over their brains.
+	void PrepareNewborns();
+
 	// Spawn an object into the simulation.
 	void SpawnObject(SimulationObject* object);
 	void SpawnObjectRandom(SimulationObject* object, bool inOrbit);
@@ -98,13 +112,34 @@ public:
 private:
 	void CalcObjectDerivedData(SimulationObject* object);
 
+	// Bin all objects into the cell grid, if any species uses cell lists.
+	void BuildCellGrid();
+
+	// Update objects in stages: every agent senses, then all brains are
+	// updated together on the simulation's threads, then every agent acts.
+	void UpdateObjectsStaged();
+	void UpdateBrains();
+	void UpdateBrainBatches();
+
 
 private:
+	// How many agents, or groups of batched brains, each thread takes at a
+	// time when updating brains.
+	static const unsigned int BRAIN_AGENTS_PER_CHUNK = 16;
+	static const unsigned int BRAIN_GROUPS_PER_CHUNK = 1;
+	static const unsigned int NEWBORNS_PER_CHUNK = 4;
+
 	Simulation*		m_simulation;
 	OctTree			m_octTree;
+	CellGrid		m_cellGrid;
 	int				m_objectIdCounter;
 	std::vector<SimulationObject*> m_objects;
 	std::map<int, SimulationObject*> m_idToObjectMap;
+
+	BrainBatch				m_brainBatches[SPECIES_COUNT];
+	std::vector<Agent*>		m_brainAgents; // Agents waiting for their brains to update.
+	std::vector<Agent*>		m_newbornAgents; // Agents waiting for their pre-birth cycles.
+	std::vector<RNG>		m_newbornRandoms; // The pre-birth random stream of each newborn.
 };
 
 
@@ -46,7 +46,9 @@ OctTree::OctTree() :
 	m_bounds(Vector3f(-1,-1,-1), Vector3f(1,1,1)),
 	m_maxDepth(4),
 	m_maxObjectsPerNode(2),
-	m_largestObjectRadius(0.0f)
+	m_largestObjectRadius(0.0f),
+	m_queryNodeCount(0),
+	m_queryObjectCount(0)
 {
 }
 
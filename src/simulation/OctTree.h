@@ -60,6 +60,11 @@ public:
 	inline OctTreeNode* GetRootNode() { return &m_root; }
 	inline unsigned int GetMaxDepth() const { return m_maxDepth; }
 	unsigned int GetNumObjects() const;
+
+	// Get the number of nodes and candidate objects visited by the most
+	// recent query.
+	inline unsigned int GetQueryNodeCount() const { return m_queryNodeCount; }
+	inline unsigned int GetQueryObjectCount() const { return m_queryObjectCount; }
 	
 	//-------------------------------------------------------------------------
 	// Setters
@@ -162,6 +167,8 @@ private:
 	unsigned int	m_maxObjectsPerNode;	// Max number of objects per node before a sub-division happens (increasing depth)
 	ObjectToNodeMap	m_objectToNodeMap;		// Maps objects to the nodes in which they're contained
 	float			m_largestObjectRadius;	// Keeps track of the largest object radius in the tree
+	unsigned int	m_queryNodeCount;		// Nodes visited by the most recent query
+	unsigned int	m_queryObjectCount;		// Objects tested by the most recent query
 };
 
 
@@ -182,6 +189,8 @@ void OctTree::Query(const AABB& box, T_QueryCallback callback)
 	queryBounds.maxs += inflation;
 
 	// Recursively perform the query.
+	m_queryNodeCount = 0;
+	m_queryObjectCount = 0;
 	DoBoxQuery(&m_root, m_bounds, queryBounds, box, callback);
 }
 
@@ -198,6 +207,8 @@ void OctTree::Query(const Sphere& sphere, T_QueryCallback callback)
 	queryBounds.maxs = sphere.position + halfSize;
 
 	// Recursively perform the query.
+	m_queryNodeCount = 0;
+	m_queryObjectCount = 0;
 	DoSphereQuery(&m_root, m_bounds, queryBounds, sphere, callback);
 }
 
@@ -208,6 +219,9 @@ void OctTree::DoBoxQuery(OctTreeNode* sectorNode,
 							const AABB& box,
 							T_QueryCallback callback)
 {
+	m_queryNodeCount++;
+	m_queryObjectCount += sectorNode->m_objects.size();
+
 	// Recursively query the child nodes.
 	for (unsigned char i = 0; i < 8; ++i)
 	{
@@ -246,6 +260,9 @@ void OctTree::DoSphereQuery(OctTreeNode* sectorNode,
 							const Sphere& sphere,
 							T_QueryCallback callback)
 {
+	m_queryNodeCount++;
+	m_queryObjectCount += sectorNode->m_objects.size();
+
 	// Recursively query the child nodes.
 	for (unsigned char i = 0; i < 8; ++i)
 	{
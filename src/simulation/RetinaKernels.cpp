@@ -0,0 +1,303 @@
+#include "RetinaKernels.h"
+#include <math/MathLib.h>
+#include <utilities/SIMD.h>
+#include <string.h>
+
+
+//-----------------------------------------------------------------------------
+// Pixel kernels
+//-----------------------------------------------------------------------------
+
+// The widest lane type enabled for this build.
+#if defined(SEAL_SIMD_AVX2)
+	typedef AVX2Lanes RetinaLanes;
+#elif defined(SEAL_SIMD_SSE2)
+	typedef SSELanes RetinaLanes;
+#else
+	typedef ScalarLanes RetinaLanes;
+#endif
+
+// Pixel indices of the lanes within a vector.
+static const float LANE_INDICES[8] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+
+// Write a value into the pixels [index1, index2] which pass the depth test.
+// Whole vectors are processed, so the arrays must be padded to a multiple of
+// the lane width.
+template <class L>
+static inline void FillSpan(float* colors, float* depths,
+	int index1, int index2, float value, float depth)
+{
+	typedef typename L::Type V;
+	typedef typename L::Mask M;
+
+	V first = L::Set((float) index1 - 0.5f);
+	V last = L::Set((float) index2 + 0.5f);
+	V values = L::Set(value);
+	V depthValues = L::Set(depth);
+	V laneIndices = L::Load(LANE_INDICES);
+
+	int begin = index1 - (index1 % (int) L::WIDTH);
+	for (int i = begin; i <= index2; i += L::WIDTH)
+	{
+		V indices = L::Add(L::Set((float) i), laneIndices);
+		V oldDepths = L::Load(depths + i);
+		M write = L::And(L::And(L::Less(first, indices), L::Less(indices, last)),
+			L::Less(depthValues, oldDepths));
+		L::Store(colors + i, L::Select(write, values, L::Load(colors + i)));
+		L::Store(depths + i, L::Select(write, depthValues, oldDepths));
+	}
+}
+
+// Get the bits of a 64-pixel coverage word which are within [index1, index2].
+static inline unsigned long long GetSpanWordMask(unsigned int word, int index1, int index2)
+{
+	int wordBegin = (int) word * 64;
+	int first = Math::Max(index1, wordBegin) - wordBegin;
+	int last = Math::Min(index2, wordBegin + 63) - wordBegin;
+	if (first > last)
+		return 0;
+	return ((2ull << last) - 1) & ~((1ull << first) - 1);
+}
+
+
+//-----------------------------------------------------------------------------
+// FixedRetinaKernel - Retinas with three channels and a resolution of at most
+//                     T_MAX_RESOLUTION, drawn into padded local arrays.
+//-----------------------------------------------------------------------------
+template <unsigned int T_MAX_RESOLUTION>
+class FixedRetinaKernel
+{
+public:
+	static const unsigned int NUM_CHANNELS = 3;
+	static const unsigned int NUM_EYES = VisionBatchParams::MAX_EYES;
+	static const unsigned int NUM_WORDS = (T_MAX_RESOLUTION + 63) / 64;
+
+	static void DrawBatch(VisionBatch& batch, const RetinaKernelParams& params)
+	{
+		FixedRetinaKernel kernel(params);
+		if (params.frontToBack)
+			kernel.DrawFrontToBack(batch);
+		else
+			kernel.DrawDepthTested(batch);
+		kernel.WriteSightInputs(params);
+	}
+
+private:
+	FixedRetinaKernel(const RetinaKernelParams& params) :
+		m_numEyes(params.numEyes),
+		m_numSaturatedEyes(0)
+	{
+		for (unsigned int channel = 0; channel < NUM_CHANNELS; ++channel)
+		{
+			m_resolutions[channel] = (int) params.resolutions[channel];
+			m_resolutionScales[channel] = (float) params.resolutions[channel];
+		}
+
+		for (unsigned int eye = 0; eye < NUM_EYES; ++eye)
+		{
+			m_numUncoveredChannels[eye] = 0;
+			for (unsigned int channel = 0; channel < NUM_CHANNELS; ++channel)
+			{
+				for (unsigned int i = 0; i < T_MAX_RESOLUTION; ++i)
+				{
+					m_colors[eye][channel][i] = 0.0f; // Clear sight value to 0 (black).
+					m_depths[eye][channel][i] = 1.0f; // Clear depth to max depth.
+				}
+				for (unsigned int word = 0; word < NUM_WORDS; ++word)
+				{
+					m_coveredMasks[eye][channel][word] = 0;
+					m_fullMasks[eye][channel][word] = GetSpanWordMask(
+						word, 0, m_resolutions[channel] - 1);
+				}
+				if (m_resolutions[channel] > 0)
+					m_numUncoveredChannels[eye]++;
+			}
+		}
+	}
+
+	// Draw the visible objects nearest first, skipping objects which are
+	// hidden behind already drawn ones, until every pixel is covered.
+	void DrawFrontToBack(VisionBatch& batch)
+	{
+		batch.SortVisibleByDepth(m_numEyes);
+
+		for (unsigned int order = 0; order < batch.GetNumSorted() &&
+			m_numSaturatedEyes < m_numEyes; ++order)
+		{
+			unsigned int i = batch.GetSortedIndex(order);
+			float depth = batch.GetDepth(i);
+			Vector3f color = batch.GetColor(i);
+
+			for (unsigned int eye = 0; eye < m_numEyes; ++eye)
+			{
+				float t1 = batch.GetSpanBegin(eye, i);
+				float t2 = batch.GetSpanEnd(eye, i);
+
+				// Clip it if it is outside the field of view.
+				if (m_numUncoveredChannels[eye] == 0 || t2 < 0.0f || t1 >= 1.0f)
+					continue;
+
+				DrawCoveredSpan(eye, color, t1, t2, depth);
+				if (m_numUncoveredChannels[eye] == 0)
+					m_numSaturatedEyes++;
+			}
+		}
+	}
+
+	// Draw the visible objects in their gathered order with depth testing.
+	void DrawDepthTested(const VisionBatch& batch)
+	{
+		for (unsigned int i = 0; i < batch.GetNumObjects(); ++i)
+		{
+			float depth = batch.GetDepth(i);
+			if (depth > 1.0f)
+				continue;
+
+			Vector3f color = batch.GetColor(i);
+			for (unsigned int eye = 0; eye < m_numEyes; ++eye)
+			{
+				float t1 = batch.GetSpanBegin(eye, i);
+				float t2 = batch.GetSpanEnd(eye, i);
+
+				// Clip it if it is outside the field of view.
+				if (t2 < 0.0f || t1 >= 1.0f)
+					continue;
+
+				for (unsigned int channel = 0; channel < NUM_CHANNELS; ++channel)
+				{
+					int index1, index2;
+					if (GetPixelRange(channel, t1, t2, index1, index2))
+					{
+						FillSpan<RetinaLanes>(m_colors[eye][channel],
+							m_depths[eye][channel], index1, index2,
+							color[channel], depth);
+					}
+				}
+			}
+		}
+	}
+
+	// Draw a span onto an eye, skipping channels where it is fully hidden.
+	void DrawCoveredSpan(unsigned int eye, const Vector3f& color,
+		float t1, float t2, float depth)
+	{
+		for (unsigned int channel = 0; channel < NUM_CHANNELS; ++channel)
+		{
+			int index1, index2;
+			if (!GetPixelRange(channel, t1, t2, index1, index2))
+				continue;
+
+			unsigned long long* coveredMasks = m_coveredMasks[eye][channel];
+			unsigned long long* fullMasks = m_fullMasks[eye][channel];
+			bool isHidden = true;
+			bool isFull = true;
+			for (unsigned int word = 0; word < NUM_WORDS; ++word)
+			{
+				unsigned long long spanMask = GetSpanWordMask(word, index1, index2);
+				if ((spanMask & ~coveredMasks[word]) != 0)
+					isHidden = false;
+			}
+			if (isHidden)
+				continue;
+
+			// Spans are drawn nearest first, so the depth test only passes
+			// for pixels which are not covered yet.
+			FillSpan<RetinaLanes>(m_colors[eye][channel],
+				m_depths[eye][channel], index1, index2,
+				color[channel], depth);
+
+			for (unsigned int word = 0; word < NUM_WORDS; ++word)
+			{
+				coveredMasks[word] |= GetSpanWordMask(word, index1, index2);
+				if (coveredMasks[word] != fullMasks[word])
+					isFull = false;
+			}
+			if (isFull)
+				m_numUncoveredChannels[eye]--;
+		}
+	}
+
+	// Get the range of pixels (inclusive) covered by the span [t1, t2].
+	// Returns false if the channel has no pixels.
+	inline bool GetPixelRange(unsigned int channel, float t1, float t2,
+		int& outIndex1, int& outIndex2) const
+	{
+		int resolution = m_resolutions[channel];
+		if (resolution == 0)
+			return false;
+		float scale = m_resolutionScales[channel];
+		outIndex1 = Math::Clamp((int) (t1 * scale), 0, resolution - 1);
+		outIndex2 = Math::Clamp((int) (t2 * scale), 0, resolution - 1);
+		return true;
+	}
+
+	// Copy the retinas into the brain's sight inputs, which are ordered by
+	// channel, then eye, then pixel.
+	void WriteSightInputs(const RetinaKernelParams& params) const
+	{
+		unsigned int stride = params.sightInputStride;
+		float* sightInputs = params.sightInputs;
+		for (unsigned int channel = 0; channel < NUM_CHANNELS; ++channel)
+		{
+			for (unsigned int eye = 0; eye < m_numEyes; ++eye)
+			{
+				memcpy(sightInputs, m_colors[eye][channel], stride * sizeof(float));
+				sightInputs += stride;
+			}
+		}
+	}
+
+private:
+	unsigned int		m_numEyes;
+	unsigned int		m_numSaturatedEyes;
+	int					m_resolutions[NUM_CHANNELS];
+	float				m_resolutionScales[NUM_CHANNELS];
+	unsigned int		m_numUncoveredChannels[NUM_EYES];
+	unsigned long long	m_coveredMasks[NUM_EYES][NUM_CHANNELS][NUM_WORDS];
+	unsigned long long	m_fullMasks[NUM_EYES][NUM_CHANNELS][NUM_WORDS];
+	float				m_colors[NUM_EYES][NUM_CHANNELS][T_MAX_RESOLUTION];
+	float				m_depths[NUM_EYES][NUM_CHANNELS][T_MAX_RESOLUTION];
+};
+
+
+//-----------------------------------------------------------------------------
+// Kernel selection
+//-----------------------------------------------------------------------------
+
+unsigned int RetinaKernels::GetKernelResolution(unsigned int numEyes,
+	unsigned int numChannels, unsigned int maxResolution)
+{
+	if (numChannels != 3 || numEyes > VisionBatchParams::MAX_EYES)
+		return 0;
+	else if (maxResolution <= 8)
+		return 8;
+	else if (maxResolution <= 16)
+		return 16;
+	else if (maxResolution <= 32)
+		return 32;
+	else if (maxResolution <= 64)
+		return 64;
+	else if (maxResolution <= MAX_RESOLUTION)
+		return MAX_RESOLUTION;
+	return 0;
+}
+
+RetinaKernels::DrawBatchFunc RetinaKernels::Select(unsigned int numEyes,
+	unsigned int numChannels, unsigned int maxResolution)
+{
+	switch (GetKernelResolution(numEyes, numChannels, maxResolution))
+	{
+	case 8:
+		return &FixedRetinaKernel<8>::DrawBatch;
+	case 16:
+		return &FixedRetinaKernel<16>::DrawBatch;
+	case 32:
+		return &FixedRetinaKernel<32>::DrawBatch;
+	case 64:
+		return &FixedRetinaKernel<64>::DrawBatch;
+	case MAX_RESOLUTION:
+		return &FixedRetinaKernel<MAX_RESOLUTION>::DrawBatch;
+	default:
+		return nullptr;
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef _RETINA_KERNELS_H_
+#define _RETINA_KERNELS_H_
+
+#include "Vision.h"
+#include "VisionBatch.h"
+
+
+//-----------------------------------------------------------------------------
+// RetinaKernelParams - The retina layout of an agent, and where to write
+//                      its sight values among its brain's input neurons.
+//-----------------------------------------------------------------------------
+struct RetinaKernelParams
+{
+	unsigned int	numEyes;
+	unsigned int	resolutions[Retina::MAX_CHANNELS]; // The same for every eye.
+	unsigned int	sightInputStride; // The species' max sight resolution.
+	float*			sightInputs; // The first sight input neuron activation.
+	bool			frontToBack;
+};
+
+
+//-----------------------------------------------------------------------------
+// RetinaKernels - Rasterizes a projected vision batch onto an agent's
+//                 retinas, then writes the retinas to the brain's sight
+//                 inputs. Kernels are specialized at compile time for three
+//                 color channels and a maximum retina resolution, so every
+//                 channel is drawn into fixed-size padded arrays with SIMD
+//                 and without any runtime layout math. A kernel is selected
+//                 once when an agent spawns.
+//-----------------------------------------------------------------------------
+class RetinaKernels
+{
+public:
+	typedef void (*DrawBatchFunc)(VisionBatch& batch, const RetinaKernelParams& params);
+
+	// The largest resolution with a specialized kernel. Agents with higher
+	// resolutions use the general Retina code.
+	static const unsigned int MAX_RESOLUTION = 128;
+
+	// Select the kernel for the given retina layout, or return nullptr if
+	// there is no specialized kernel for it.
+	static DrawBatchFunc Select(unsigned int numEyes, unsigned int numChannels,
+		unsigned int maxResolution);
+
+	// Get the resolution that the selected kernel was specialized for, or
+	// zero if there is no specialized kernel.
+	static unsigned int GetKernelResolution(unsigned int numEyes,
+		unsigned int numChannels, unsigned int maxResolution);
+};
+
+
+#endif // _RETINA_KERNELS_H_
@@ -0,0 +1,110 @@
+#include "SigmoidFunctions.h"
+#include "BrainKernels.h"
+#include <math/MathLib.h>
+#include <math.h>
+
+
+float SigmoidFunctions::s_table[TABLE_SIZE];
+bool SigmoidFunctions::s_isTableInitialized = false;
+
+// Build the sigmoid table during static initialization, before any brain
+// can be updated (possibly from several threads).
+static struct SigmoidTableInitializer
+{
+	SigmoidTableInitializer() { SigmoidFunctions::Evaluate(SIGMOID_TABLE, 0.0f, 1.0f); }
+} s_sigmoidTableInitializer;
+
+
+//-----------------------------------------------------------------------------
+// Public methods
+//-----------------------------------------------------------------------------
+
+const char* SigmoidFunctions::GetName(SigmoidFunction function)
+{
+	switch (function)
+	{
+	case SIGMOID_EXACT:			return "exact";
+	case SIGMOID_RATIONAL:		return "rational";
+	case SIGMOID_TABLE:			return "table";
+	case SIGMOID_POLYNOMIAL:	return "polynomial";
+	default:					return "unknown";
+	}
+}
+
+float SigmoidFunctions::Evaluate(SigmoidFunction function, float x, float slope)
+{
+	switch (function)
+	{
+	case SIGMOID_RATIONAL:
+		return RationalSigmoidLanes<ScalarLanes>(x, 0.5f * slope);
+	case SIGMOID_TABLE:
+		if (!s_isTableInitialized)
+			InitTable();
+		return EvaluateTable(x * slope);
+	case SIGMOID_POLYNOMIAL:
+		return SigmoidLanes<ScalarLanes>(x, -slope);
+	default:
+		return (1.0f / (1.0f + Math::Exp(-x * slope)));
+	}
+}
+
+void SigmoidFunctions::Apply(SigmoidFunction function, float* values,
+	unsigned int count, float slope)
+{
+	typedef BrainLanes L;
+	unsigned int i = 0;
+
+	if (function == SIGMOID_TABLE && !s_isTableInitialized)
+		InitTable();
+
+	if (function == SIGMOID_RATIONAL)
+	{
+		L::Type halfSlope = L::Set(0.5f * slope);
+		for (; i + L::WIDTH <= count; i += L::WIDTH)
+			L::Store(values + i, RationalSigmoidLanes<L>(L::Load(values + i), halfSlope));
+	}
+	else if (function == SIGMOID_POLYNOMIAL)
+	{
+		L::Type negSlope = L::Set(-slope);
+		for (; i + L::WIDTH <= count; i += L::WIDTH)
+			L::Store(values + i, SigmoidLanes<L>(L::Load(values + i), negSlope));
+	}
+	else if (function == SIGMOID_TABLE)
+	{
+		for (; i < count; ++i)
+			values[i] = EvaluateTable(values[i] * slope);
+	}
+
+	// The remaining values, or all of them for the exact function.
+	for (; i < count; ++i)
+		values[i] = Evaluate(function, values[i], slope);
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+float SigmoidFunctions::EvaluateTable(float x)
+{
+	float position = (x + TABLE_RANGE) * TABLE_STEPS_PER_UNIT;
+	if (position <= 0.0f)
+		return s_table[0];
+	if (position >= TABLE_SIZE - 1)
+		return s_table[TABLE_SIZE - 1];
+
+	// Interpolate between the two nearest entries.
+	int index = (int) position;
+	float t = position - index;
+	return s_table[index] + ((s_table[index + 1] - s_table[index]) * t);
+}
+
+void SigmoidFunctions::InitTable()
+{
+	for (int i = 0; i < TABLE_SIZE; ++i)
+	{
+		double x = ((double) i / TABLE_STEPS_PER_UNIT) - TABLE_RANGE;
+		s_table[i] = (float) (1.0 / (1.0 + exp(-x)));
+	}
+	s_isTableInitialized = true;
+}
@@ -0,0 +1,53 @@
+#ifndef _SIGMOID_FUNCTIONS_H_
+#define _SIGMOID_FUNCTIONS_H_
+
+
+//-----------------------------------------------------------------------------
+// SigmoidFunction - The ways of computing a neuron's sigmoid activation.
+//-----------------------------------------------------------------------------
+enum SigmoidFunction
+{
+	SIGMOID_EXACT = 0,		// 1 / (1 + e^(-x)), with the C library's exp.
+	SIGMOID_RATIONAL,		// A rational approximation of tanh, with SIMD.
+	SIGMOID_TABLE,			// Table lookup with linear interpolation.
+	SIGMOID_POLYNOMIAL,		// A polynomial approximation of exp, with SIMD.
+
+	NUM_SIGMOID_FUNCTIONS
+};
+
+
+//-----------------------------------------------------------------------------
+// SigmoidFunctions - Computes the sigmoid function 1 / (1 + e^(-x * slope))
+//                    with one of several implementations, trading accuracy
+//                    for speed.
+//-----------------------------------------------------------------------------
+class SigmoidFunctions
+{
+public:
+	// The sigmoid table covers inputs within +/- TABLE_RANGE, with
+	// TABLE_STEPS_PER_UNIT entries for every unit of input. Beyond that
+	// range the sigmoid is within 2e-7 of 0 or 1.
+	static const int TABLE_RANGE = 16;
+	static const int TABLE_STEPS_PER_UNIT = 64;
+	static const int TABLE_SIZE = (2 * TABLE_RANGE * TABLE_STEPS_PER_UNIT) + 1;
+
+	// Get the name of a sigmoid function, as used in reports.
+	static const char* GetName(SigmoidFunction function);
+
+	// Compute the sigmoid function for a single value.
+	static float Evaluate(SigmoidFunction function, float x, float slope);
+
+	// Compute the sigmoid function for an array of values, in place.
+	static void Apply(SigmoidFunction function, float* values,
+		unsigned int count, float slope);
+
+private:
+	static float EvaluateTable(float x);
+	static void InitTable();
+
+	static float s_table[TABLE_SIZE];
+	static bool s_isTableInitialized;
+};
+
+
+#endif // _SIGMOID_FUNCTIONS_H_
@@ -46,6 +46,7 @@ void Simulation::Initialize(const SimulationConfig& config)
 		m_config.world.matingSeasonDuration;
 	m_generationIndex = 0;
 	m_generationStats.clear();
+	m_profiler.Reset();
 
 	// Seed the random number generator.
 	if (config.world.seed < 0)
@@ -60,6 +61,7 @@ void Simulation::Initialize(const SimulationConfig& config)
 	}
 
 	// Initialize systems.
+	m_threadPool.Initialize((unsigned int) Math::Max(0, m_config.world.numThreads));
 	m_world.Initialize(config.world.radius);
 	m_objectManager.Initialize();
 	m_particleSystem.Initialize();
@@ -67,6 +69,12 @@ void Simulation::Initialize(const SimulationConfig& config)
 		m_config.herbivore.fittestList.numFittestAgents);
 	m_fittestLists[SPECIES_CARNIVORE].Reset(
 		m_config.carnivore.fittestList.numFittestAgents);
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		m_brainCaches[i].Clear();
+		m_brainCaches[i].SetCapacity((unsigned int) Math::Max(0,
+			m_config.species[i].brain.topologyCacheSize));
+	}
 	
 	// Spawn initial plants.
 	for (int i = 0; i < m_config.plant.numPlants; ++i)
@@ -80,22 +88,28 @@ void Simulation::Initialize(const SimulationConfig& config)
 
 	m_numAgents[SPECIES_HERBIVORE] = m_config.herbivore.population.initialAgents;
 	m_numAgents[SPECIES_CARNIVORE] = m_config.carnivore.population.initialAgents;
+
+	// Prepare the brains of all initial agents at once.
+	m_objectManager.PrepareNewborns();
 }
 
 void Simulation::OnNewSimulation()
 {
 	m_particleSystem.Initialize();
+	m_profiler.Reset();
 }
 
 void Simulation::Tick()
 {
 	double startTime = Time::GetTime();
+	m_profiler.BeginTick();
 
 	// Update systems.
 	m_ageInTicks++;
 	m_objectManager.UpdateObjects();
 	m_particleSystem.Update();
 	UpdateSteadyStateGA();
+	m_objectManager.PrepareNewborns();
 
 	// Advance to the next generation.
 	m_generationAge++;
@@ -113,6 +127,7 @@ void Simulation::Tick()
 	// Measure elapsed time.
 	double endTime = Time::GetTime();
 	double elapsedTimeInMs = (endTime - startTime) * 1000.0;
+	m_profiler.EndTick((float) elapsedTimeInMs);
 }
 
 
@@ -180,8 +195,8 @@ void Simulation::GenerateNewAgent(Species species)
 		fittestList.IsFull())
 	{
 		// Mate two fittest agents.
-		Genome* mommy;
-		Genome* daddy;
+		const Genome* mommy;
+		const Genome* daddy;
 		fittestList.PickTwoTournamentSelection(
 			m_random, config.fittestList.mateTournamentSize,
 			mommy, daddy);
@@ -202,9 +217,11 @@ void Simulation::GenerateNewAgent(Species species)
 	}
 	else
 	{
-		// Use an elite, unaltered agent genome from the fittest list.
-		Genome* genome = fittestList.PickOneRandom(m_random);
-		Agent* elite = new Agent(new Genome(*genome), 100, species);
+		// Use an elite, unaltered agent genome from the fittest list, which
+		// the elite shares with it.
+		const Genome* genome = fittestList.PickOneRandom(m_random);
+		genome->AddReference();
+		Agent* elite = new Agent(genome, 100, species);
 		m_objectManager.SpawnObjectRandom(elite, true);
 
 		// Max's are determined after OnSpawn(), through SpawnObjectRandom()
@@ -220,7 +237,7 @@ void Simulation::GenerateNewAgent(Species species)
 
 #define SIMULATION_FILE_MAGIC_1   'LAES'	// these will appear backwards in file
 #define SIMULATION_FILE_MAGIC_2   'RBJD'
-#define SIMULATION_FILE_VERSION   2
+#define SIMULATION_FILE_VERSION   3
 
 bool Simulation::ReadSimulation(std::ifstream& fileIn)
 {
@@ -256,8 +273,15 @@ bool Simulation::ReadSimulation(std::ifstream& fileIn)
 	fileIn.read((char*)&m_statistics, sizeof(SimulationStats));
 
 	// Re-initialize some systems.
+	m_threadPool.Initialize((unsigned int) Math::Max(0, m_config.world.numThreads));
 	m_world.Initialize(m_config.world.radius);
 	m_objectManager.Initialize();
+	for (unsigned int i = 0; i < SPECIES_COUNT; ++i)
+	{
+		m_brainCaches[i].Clear();
+		m_brainCaches[i].SetCapacity((unsigned int) Math::Max(0,
+			m_config.species[i].brain.topologyCacheSize));
+	}
 
 	// Read all generation statistics
 	unsigned int numStats;
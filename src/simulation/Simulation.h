@@ -1,15 +1,19 @@
 #ifndef _SIMULATION_H_
 #define _SIMULATION_H_
 
+#include <simulation/BrainCache.h>
 #include <simulation/FittestList.h>
 #include <simulation/ObjectManager.h>
 #include <simulation/OctTree.h>
 #include <simulation/SimulationConfig.h>
 #include <simulation/SimulationObject.h>
 #include <simulation/SimulationStats.h>
+#include <simulation/TickProfiler.h>
+#include <simulation/VisionBatch.h>
 #include <simulation/World.h>
 #include <graphics/ParticleSystem.h>
 #include <utilities/Random.h>
+#include <utilities/ThreadPool.h>
 
 
 //-----------------------------------------------------------------------------
@@ -31,12 +35,19 @@ public:
 	inline World* GetWorld() { return &m_world; }
 	inline OctTree* GetOctTree() { return m_objectManager.GetOctTree(); }
 	inline RNG& GetRandom() { return m_random; }
+	inline VisionBatch& GetVisionBatch() { return m_visionBatch; }
+	inline std::vector<SimulationObject*>& GetVisionCandidates() { return m_visionCandidates; }
 	inline int GetNumAgents(Species species) const { return m_numAgents[(int) species]; }
 
 	inline const SimulationConfig& GetConfig() const { return m_config; }
 	inline const SpeciesConfig& GetAgentConfig(Species species) const { return m_config.species[(int) species]; }
+	inline SpeciesConfig& GetAgentConfig(Species species) { return m_config.species[(int) species]; }
 
 	inline const SimulationStats& GetStatistics() const { return m_statistics; }
+	inline TickProfiler& GetProfiler() { return m_profiler; }
+	inline ThreadPool& GetThreadPool() { return m_threadPool; }
+	inline BrainCache* GetBrainCache(Species species) { return &m_brainCaches[species]; }
+	inline const TickProfiler& GetProfiler() const { return m_profiler; }
 	inline unsigned int GetAgeInTicks() const { return m_ageInTicks; }
 	inline unsigned long GetOriginalSeed() const { return m_originalSeed; }
 	inline unsigned int GetGeneration() const { return m_generationIndex; }
@@ -107,7 +118,12 @@ private:
 	ParticleSystem		m_particleSystem;
 	RNG					m_random;
 	SimulationStats		m_statistics;
+	TickProfiler		m_profiler;
+	ThreadPool			m_threadPool;
 	FittestList			m_fittestLists[SPECIES_COUNT];
+	BrainCache			m_brainCaches[SPECIES_COUNT]; // Recently grown brain topologies.
+	VisionBatch			m_visionBatch; // Scratch space for agent vision.
+	std::vector<SimulationObject*>	m_visionCandidates; // Scratch space for agent vision.
 
 	unsigned int		m_numAgents[SPECIES_COUNT];
 
@@ -1,4 +1,6 @@
 #include "SimulationConfig.h"
+#include "SigmoidFunctions.h"
+#include "Brain.h"
 #include <math/MathLib.h>
 
 
@@ -10,6 +12,7 @@ SimulationConfig::SimulationConfig()
 	world.seed					= -1;
 	world.matingSeasonDuration	= 60 * 12;
 	world.offSeasonDuration		= 60 * 18;
+	world.numThreads			= 0;
 
 	//-------------------------------------------------------------------------
 	// Plant
@@ -81,15 +84,35 @@ SimulationConfig::SimulationConfig()
 	herbivore.genes.maxBodyColor[1]			= 0.0f;
 	herbivore.genes.minBodyColor[2]			= 1.0f;
 	herbivore.genes.maxBodyColor[2]			= 1.0f;
+	herbivore.genes.useFastSpawning			= true;
+	
+	herbivore.vision.useAnalyticProjection	= true;
+	herbivore.vision.useBatchKernel			= true;
+	herbivore.vision.verifyBatchKernel		= false;
+	herbivore.vision.frontToBack			= true;
+	herbivore.vision.updateInterval			= 1;
+	herbivore.vision.staggerUpdates			= true;
+	herbivore.vision.useCellLists			= true;
+	herbivore.vision.cullBehind				= true;
+	herbivore.vision.cullBeyondHorizon		= false;
+	herbivore.vision.useSpecializedKernels	= true;
 	
 	herbivore.brain.numPrebirthCycles		= 10;
 	herbivore.brain.sigmoidSlope			= 1.0f;
+	herbivore.brain.sigmoidFunction			= SIGMOID_POLYNOMIAL;
 	herbivore.brain.maxBias					= 1.0f;
 	herbivore.brain.initMaxWeight			= 0.5f;
 	herbivore.brain.maxWeight				= 1.0f;
 	herbivore.brain.weightLearningRate		= 0.08f;
 	herbivore.brain.weightDecayRate			= 0.998f;
 	herbivore.brain.useHebbianLearning		= true;
+	herbivore.brain.hebbianLearningInterval	= 1;
+	herbivore.brain.useDenseWeights			= true;
+	herbivore.brain.weightPrecision			= WEIGHT_PRECISION_FLOAT32;
+	herbivore.brain.useSpecializedKernels	= true;
+	herbivore.brain.useBatchedUpdate		= true;
+	herbivore.brain.pruneNetwork			= false;
+	herbivore.brain.topologyCacheSize		= 64;
 
 	//-------------------------------------------------------------------------
 	// Carnivore
@@ -109,8 +109,28 @@ struct SpeciesConfig
 		// Neurological genes
 		int		maxInternalNeurons;
 
+		bool	useFastSpawning; // copy spans between crossover points, and skip to the next mutation.
+
 	} genes;
 
+	//-------------------------------------------------------------------------
+	// Vision
+
+	struct
+	{
+		bool	useAnalyticProjection; // false = reference perspective projection.
+		bool	useBatchKernel; // project gathered objects with SIMD kernels.
+		bool	verifyBatchKernel; // check SIMD kernels against scalar and exact projections.
+		bool	frontToBack; // draw batched objects nearest first, skipping hidden ones.
+		int		updateInterval; // recompute retinas every N ticks.
+		bool	staggerUpdates; // spread retina updates evenly across agents.
+		bool	useCellLists; // gather nearby objects from per-tick cell lists.
+		bool	cullBehind; // skip objects outside the combined eye cone.
+		bool	cullBeyondHorizon; // skip objects hidden by the world's surface.
+		bool	useSpecializedKernels; // draw retinas with kernels specialized for their layout.
+
+	} vision;
+
 	//-------------------------------------------------------------------------
 	// Brain
 	
@@ -119,11 +139,19 @@ struct SpeciesConfig
 		int		numPrebirthCycles;
 		float	maxBias;
 		float	sigmoidSlope;
+		int		sigmoidFunction; // how to compute the sigmoid function (a SigmoidFunction value).
 		float	maxWeight;
 		float	initMaxWeight;
 		float	weightLearningRate;
 		float	weightDecayRate;
 		bool	useHebbianLearning;
+		int		hebbianLearningInterval; // apply Hebbian learning once every this many ticks.
+		bool	useDenseWeights; // evaluate dense brains as a weight matrix with SIMD kernels.
+		int		weightPrecision; // how dense brains store their weights (a WeightPrecision value).
+		bool	useSpecializedKernels; // update dense brains with kernels specialized for their size.
+		bool	useBatchedUpdate; // update the dense brains of a species together, with SIMD across agents.
+		bool	pruneNetwork; // remove synapses and neurons which can't affect the outputs.
+		int		topologyCacheSize; // how many grown brain topologies to keep for identical genomes.
 
 	} brain;
 };
@@ -148,6 +176,7 @@ public:
 		int		seed;	// -1 means random seed.
 		int		matingSeasonDuration; // for how many ticks does mating season occur?
 		int		offSeasonDuration; // how many ticks from when mating season ends to when it starts again
+		int		numThreads; // threads for updating brains, 0 means one per hardware thread.
 
 	} world;
 
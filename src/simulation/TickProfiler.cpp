@@ -0,0 +1,93 @@
+#include "TickProfiler.h"
+
+
+//-----------------------------------------------------------------------------
+// Constructor
+//-----------------------------------------------------------------------------
+
+TickProfiler::TickProfiler()
+{
+	Reset();
+}
+
+
+//-----------------------------------------------------------------------------
+// Profiling
+//-----------------------------------------------------------------------------
+
+void TickProfiler::Reset()
+{
+	for (unsigned int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+	{
+		m_counts[i] = 0;
+		m_lastCounts[i] = 0;
+		m_totalCounts[i] = 0.0;
+	}
+	m_lastTickTime = 0.0f;
+	m_totalTickTime = 0.0;
+	m_numTicks = 0;
+}
+
+void TickProfiler::BeginTick()
+{
+	for (unsigned int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+		m_counts[i] = 0;
+}
+
+void TickProfiler::EndTick(float elapsedTimeInMs)
+{
+	for (unsigned int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+	{
+		m_lastCounts[i] = m_counts[i];
+		m_totalCounts[i] += m_counts[i];
+	}
+	m_lastTickTime = elapsedTimeInMs;
+	m_totalTickTime += elapsedTimeInMs;
+	m_numTicks++;
+}
+
+
+//-----------------------------------------------------------------------------
+// Getters
+//-----------------------------------------------------------------------------
+
+float TickProfiler::GetAverageCount(ProfilerCounter counter) const
+{
+	if (m_numTicks == 0)
+		return 0.0f;
+	return (float) (m_totalCounts[counter] / m_numTicks);
+}
+
+float TickProfiler::GetAverageTickTime() const
+{
+	if (m_numTicks == 0)
+		return 0.0f;
+	return (float) (m_totalTickTime / m_numTicks);
+}
+
+const char* TickProfiler::GetCounterName(ProfilerCounter counter)
+{
+	switch (counter)
+	{
+	case PROFILER_VISION_REFRESHES:
+		return "vision refreshes";
+	case PROFILER_VISION_REUSES:
+		return "vision reuses";
+	case PROFILER_OCTTREE_NODES:
+		return "octtree nodes";
+	case PROFILER_OCTTREE_CANDIDATES:
+		return "octtree candidates";
+	case PROFILER_CELLS:
+		return "cells";
+	case PROFILER_CELL_CANDIDATES:
+		return "cell candidates";
+	case PROFILER_VISION_CANDIDATES:
+		return "vision candidates";
+	case PROFILER_VISION_CULLED_BEHIND:
+		return "culled behind";
+	case PROFILER_VISION_CULLED_HORIZON:
+		return "culled beyond horizon";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef _TICK_PROFILER_H_
+#define _TICK_PROFILER_H_
+
+
+//-----------------------------------------------------------------------------
+// ProfilerCounter - Counts of work done during a simulation tick.
+//-----------------------------------------------------------------------------
+enum ProfilerCounter
+{
+	PROFILER_VISION_REFRESHES = 0,	// Agents which recomputed their retinas
+	PROFILER_VISION_REUSES,			// Agents which kept their previous retinas
+	PROFILER_OCTTREE_NODES,			// Oct-tree nodes visited by vision queries
+	PROFILER_OCTTREE_CANDIDATES,	// Objects tested by oct-tree vision queries
+	PROFILER_CELLS,					// Cells visited by vision queries
+	PROFILER_CELL_CANDIDATES,		// Objects tested by cell list vision queries
+	PROFILER_VISION_CANDIDATES,		// Visible objects within an agent's vision range
+	PROFILER_VISION_CULLED_BEHIND,	// Candidates rejected by the eye cone test
+	PROFILER_VISION_CULLED_HORIZON,	// Candidates rejected by the horizon test
+
+	PROFILER_COUNTER_COUNT,
+};
+
+
+//-----------------------------------------------------------------------------
+// TickProfiler - Measures the time taken and the work done by simulation
+//                ticks. Counts are kept for the most recent tick, along with
+//                totals since the profiler was last reset.
+//-----------------------------------------------------------------------------
+class TickProfiler
+{
+public:
+	TickProfiler();
+
+	void Reset();
+	void BeginTick();
+	void EndTick(float elapsedTimeInMs);
+
+	inline void Count(ProfilerCounter counter, unsigned int amount = 1) { m_counts[counter] += amount; }
+
+	//-------------------------------------------------------------------------
+	// Getters
+
+	// Get the count from the most recently finished tick.
+	inline unsigned int GetCount(ProfilerCounter counter) const { return m_lastCounts[counter]; }
+	inline float GetTickTime() const { return m_lastTickTime; }
+
+	// Get the averages per tick since the profiler was reset.
+	float GetAverageCount(ProfilerCounter counter) const;
+	float GetAverageTickTime() const;
+
+	inline unsigned int GetNumTicks() const { return m_numTicks; }
+
+	static const char* GetCounterName(ProfilerCounter counter);
+
+private:
+	unsigned int		m_counts[PROFILER_COUNTER_COUNT];
+	unsigned int		m_lastCounts[PROFILER_COUNTER_COUNT];
+	double				m_totalCounts[PROFILER_COUNTER_COUNT];
+	float				m_lastTickTime; // in milliseconds.
+	double				m_totalTickTime;
+	unsigned int		m_numTicks;
+};
+
+
+#endif // _TICK_PROFILER_H_
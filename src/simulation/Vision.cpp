@@ -1,151 +1,190 @@
 #include "Vision.h"
 #include <assert.h>
 #include <math/MathLib.h>
+#include <math/Vector3f.h>
 #include <string.h>
 
 
-//-----------------------------------------------------------------------------
-// VisionChannel
-//-----------------------------------------------------------------------------
-	
-VisionChannel::VisionChannel() :
-	m_colorBuffer(nullptr),
-	m_depthBuffer(nullptr),
-	m_resolution(0),
-	m_channelIndex(0)
-{
-}
-
-VisionChannel::~VisionChannel()
-{
-	delete [] m_colorBuffer;
-	m_colorBuffer = nullptr;
-	delete [] m_depthBuffer;
-	m_depthBuffer = nullptr;
-}
-
-void VisionChannel::Configure(unsigned int channelIndex, unsigned int resolution)
-{
-	delete [] m_colorBuffer;
-	delete [] m_depthBuffer;
-	m_resolution = resolution;
-	m_channelIndex = channelIndex;
-	m_colorBuffer = new float[m_resolution];
-	m_depthBuffer = new float[m_resolution];
-}
-
-void VisionChannel::Clear()
-{
-	for (unsigned int i = 0; i < m_resolution; ++i)
-	{
-		m_colorBuffer[i] = 0.0f; // Clear sight value to 0 (black).
-		m_depthBuffer[i] = 1.0f; // Clear depth to max depth.
-	}
-}
-	
-float VisionChannel::GetSightValue(unsigned int index) const
-{
-	assert(index < m_resolution);
-	return m_colorBuffer[index];
-}
-
-float VisionChannel::GetInterpolatedSightValue(float t) const
-{
-	if (m_resolution == 0)
-		return 0.0f;
-	else if (m_resolution == 1)
-		return m_colorBuffer[0];
-	
-	t = Math::Clamp(t, 0.0f, 1.0f);
-
-	float neuronIndex = (t * m_resolution) - 0.5f;
-	int index0 = Math::Max((int) neuronIndex + 0, 0);
-	int index1 = Math::Min((int) neuronIndex + 1, (int) m_resolution - 1);
-	float lerpFactor = neuronIndex - (float) index0;
-
-	return Math::Lerp(GetSightValue(index0), GetSightValue(index1), lerpFactor);
-}
-
-
 //-----------------------------------------------------------------------------
 // Retina
 //-----------------------------------------------------------------------------
 
 Retina::Retina() :
 	m_viewDistance(1.0f),
-	m_numChannels(3),
-	m_fieldOfView(0.8f)
+	m_numChannels(0),
+	m_fieldOfView(0.8f),
+	m_invFieldOfView(1.0f / 0.8f),
+	m_centerAngle(0.0f),
+	m_channelStride(0),
+	m_colorBuffer(nullptr),
+	m_depthBuffer(nullptr)
 {
-	m_channels = new VisionChannel[m_numChannels];
 }
 
 Retina::~Retina()
 {
-	delete [] m_channels;
-	m_channels = nullptr;
 }
 
 void Retina::Configure(float fieldOfView, float viewDistance,
+		float centerAngle, float nearDistance,
 		unsigned int numChannels, unsigned int* channelResolutions)
 {
+	assert(numChannels <= MAX_CHANNELS);
+
 	m_fieldOfView = fieldOfView;
+	m_invFieldOfView = 1.0f / fieldOfView;
 	m_viewDistance = viewDistance;
-
-	// Reallocate the channels buffer if need-be.
-	if (m_channels == nullptr || m_numChannels != numChannels)
-	{
-		delete m_channels;
-		m_numChannels = numChannels;
-		m_channels = new VisionChannel[m_numChannels];
-	}
-
-	// Configure each channels.
+	m_centerAngle = centerAngle;
+	m_agentToEye = Matrix4f::CreateRotation(Vector3f::UNITY, centerAngle);
+	m_eyeToProjection = Matrix4f::CreatePerspective(
+		fieldOfView, 1.0f, nearDistance, viewDistance);
+	m_numChannels = numChannels;
 	for (unsigned int i = 0; i < m_numChannels; ++i)
-		m_channels[i].Configure(i, channelResolutions[i]);
+		m_resolutions[i] = channelResolutions[i];
 }
 
-unsigned int Retina::GetResolution(unsigned int channel) const
+void Retina::SetBuffers(float* colorBuffer, float* depthBuffer,
+	unsigned int channelStride)
 {
-	assert(channel < m_numChannels);
-	return m_channels[channel].m_resolution;
+	m_colorBuffer = colorBuffer;
+	m_depthBuffer = depthBuffer;
+	m_channelStride = channelStride;
 }
 
 float Retina::GetSightValueAtIndex(unsigned int channel, unsigned int index) const
 {
 	assert(channel < m_numChannels);
-	return m_channels[channel].GetSightValue(index);
+	assert(index < m_resolutions[channel]);
+	return m_colorBuffer[(channel * m_channelStride) + index];
 }
 
 float Retina::GetSightValue(unsigned int channel, float t) const
 {
 	assert(channel < m_numChannels);
-	int index = (int) (m_channels[channel].m_resolution * t);
-	index = Math::Clamp(index, 0, (int) m_channels[channel].m_resolution - 1);
-	return m_channels[channel].GetSightValue((unsigned int) index);
+	int index = (int) (m_resolutions[channel] * t);
+	index = Math::Clamp(index, 0, (int) m_resolutions[channel] - 1);
+	return GetSightValueAtIndex(channel, (unsigned int) index);
 }
 
 float Retina::GetInterpolatedSightValue(unsigned int channel, float t) const
 {
 	assert(channel < m_numChannels);
-	return m_channels[channel].GetInterpolatedSightValue(t);
+	unsigned int resolution = m_resolutions[channel];
+	if (resolution == 0)
+		return 0.0f;
+	else if (resolution == 1)
+		return GetSightValueAtIndex(channel, 0);
+	
+	t = Math::Clamp(t, 0.0f, 1.0f);
+
+	float neuronIndex = (t * resolution) - 0.5f;
+	int index0 = Math::Max((int) neuronIndex + 0, 0);
+	int index1 = Math::Min((int) neuronIndex + 1, (int) resolution - 1);
+	float lerpFactor = neuronIndex - (float) index0;
+
+	return Math::Lerp(GetSightValueAtIndex(channel, index0),
+		GetSightValueAtIndex(channel, index1), lerpFactor);
+}
+
+// Get the range of pixels (inclusive) covered by the span [t1, t2].
+void Retina::GetPixelRange(unsigned int channel, float t1, float t2, int& outIndex1, int& outIndex2) const
+{
+	assert(channel < m_numChannels);
+	int resolution = (int) m_resolutions[channel];
+	outIndex1 = Math::Clamp((int) (t1 * resolution), 0, resolution - 1);
+	outIndex2 = Math::Clamp((int) (t2 * resolution), 0, resolution - 1);
 }
 
 void Retina::ClearSightValues()
 {
-	// Clear each channel.
-	for (unsigned int i = 0; i < m_numChannels; ++i)
-		m_channels[i].Clear();
+	for (unsigned int channel = 0; channel < m_numChannels; ++channel)
+	{
+		float* colors = m_colorBuffer + (channel * m_channelStride);
+		float* depths = m_depthBuffer + (channel * m_channelStride);
+		for (unsigned int i = 0; i < m_resolutions[channel]; ++i)
+		{
+			colors[i] = 0.0f; // Clear sight value to 0 (black).
+			depths[i] = 1.0f; // Clear depth to max depth.
+		}
+	}
 }
 
-void Retina::SetSightValue(unsigned int channel, unsigned int index, float sightValue, float depth)
+
+//-----------------------------------------------------------------------------
+// RetinaCoverage
+//-----------------------------------------------------------------------------
+
+void RetinaCoverage::Reset(const Retina& retina)
 {
-	assert(channel < m_numChannels);
-	assert(index < m_channels[channel].m_resolution);
+	m_numUncoveredChannels = retina.GetNumChannels();
+	for (unsigned int channel = 0; channel < retina.GetNumChannels(); ++channel)
+	{
+		unsigned int resolution = retina.GetResolution(channel);
+		assert(resolution <= MAX_RESOLUTION);
+		m_coveredMasks[channel] = 0;
+		m_fullMasks[channel] = (resolution >= 64 ? ~0ull : (1ull << resolution) - 1);
+		if (resolution == 0)
+			m_numUncoveredChannels--;
+	}
+}
 
-	// Perform a depth test.
-	if (depth < m_channels[channel].m_depthBuffer[index])
+void RetinaCoverage::DrawSpan(Retina& retina, const Vector3f& color, float t1, float t2, float depth)
+{
+	for (unsigned int channel = 0; channel < retina.GetNumChannels(); ++channel)
 	{
-		m_channels[channel].m_colorBuffer[index] = sightValue;
-		m_channels[channel].m_depthBuffer[index] = depth;
+		unsigned long long coveredMask = m_coveredMasks[channel];
+		if (coveredMask == m_fullMasks[channel])
+			continue;
+
+		// Skip the channel if the span is fully occluded.
+		int index1, index2;
+		retina.GetPixelRange(channel, t1, t2, index1, index2);
+		unsigned long long spanMask = ((2ull << index2) - 1) & ~((1ull << index1) - 1);
+		if ((spanMask & ~coveredMask) == 0)
+			continue;
+
+		// Only write the uncovered pixels.
+		for (int index = index1; index <= index2; index++)
+		{
+			if ((coveredMask & (1ull << index)) == 0)
+				retina.SetSightValue(channel, (unsigned int) index, color[channel], depth);
+		}
+
+		m_coveredMasks[channel] = coveredMask | spanMask;
+		if (m_coveredMasks[channel] == m_fullMasks[channel])
+			m_numUncoveredChannels--;
 	}
 }
+
+
+//-----------------------------------------------------------------------------
+// VisionCuller
+//-----------------------------------------------------------------------------
+
+VisionCuller::VisionCuller() :
+	m_coneCos(-1.0f),
+	m_coneSin(0.0f),
+	m_worldRadiusSqr(0.0f),
+	m_eyeHorizonDistance(0.0f),
+	m_cullBehind(false),
+	m_cullBeyondHorizon(false)
+{
+}
+
+void VisionCuller::Setup(const Matrix4f& worldToAgent, float coneHalfAngle,
+	float eyeHeight, float worldRadius, bool cullBehind,
+	bool cullBeyondHorizon)
+{
+	m_worldToAgent = worldToAgent;
+	m_coneCos = Math::Cos(coneHalfAngle);
+	m_coneSin = Math::Sin(coneHalfAngle);
+
+	// A cone wider than a full circle can see in every direction.
+	m_cullBehind = (cullBehind && coneHalfAngle < Math::PI);
+
+	m_cullBeyondHorizon = cullBeyondHorizon;
+	m_worldRadiusSqr = worldRadius * worldRadius;
+	float eyeHorizonDistSqr = (eyeHeight * eyeHeight) - m_worldRadiusSqr;
+	m_eyeHorizonDistance = (eyeHorizonDistSqr > 0.0f ?
+		Math::Sqrt(eyeHorizonDistSqr) : 0.0f);
+}
@@ -1,72 +1,184 @@
 #ifndef _VISION_H_
 #define _VISION_H_
 
+#include <math/MathLib.h>
 #include <math/Matrix4f.h>
-
-
-//-----------------------------------------------------------------------------
-// VisionChannel - a single color channel for a vision strip.
-//-----------------------------------------------------------------------------
-class VisionChannel
-{
-public:
-	friend class Retina;
-
-	VisionChannel();
-	~VisionChannel();
-
-	void Configure(unsigned int channelIndex, unsigned int resolution);
-
-	void Clear();
-	float GetSightValue(unsigned int index) const;
-	float GetInterpolatedSightValue(float t) const;
-	
-private:
-	unsigned int	m_channelIndex;
-	unsigned int	m_resolution;
-	float*			m_colorBuffer; // color values for each pixel
-	float*			m_depthBuffer; // depth values for each pixel. 0 = close, 1 = far.
-};
+#include <math/Vector3f.h>
+#include <assert.h>
 
 
 //-----------------------------------------------------------------------------
 // Retina - An eyeball that stores a strip of color data, and is positioned
-//          on an agent's body.
+//          on an agent's body. The retina does not own its sight values;
+//          they are stored in buffers owned by the agent, where each
+//          channel's values are placed channelStride floats apart.
 //-----------------------------------------------------------------------------
 class Retina
 {
 public:
+	static const unsigned int MAX_CHANNELS = 3;
+
 	Retina();
 	~Retina();
 
+	// Configure the eye's vision, as well as its placement on the agent: the
+	// angle it looks at in agent-space and its near plane distance. The
+	// eye's rotation and projection matrices are computed here once.
 	void Configure(float fieldOfView, float viewDistance,
+		float centerAngle, float nearDistance,
 		unsigned int numChannels, unsigned int* channelResolutions);
 
+	// Set the buffers for color values and depth values (0 = close, 1 = far).
+	void SetBuffers(float* colorBuffer, float* depthBuffer,
+		unsigned int channelStride);
+
 	inline float GetViewDistance() const { return m_viewDistance; }
 	inline float GetFieldOfView() const { return m_fieldOfView; }
+	inline float GetInvFieldOfView() const { return m_invFieldOfView; }
+	inline float GetCenterAngle() const { return m_centerAngle; }
 	inline unsigned int GetNumChannels() const { return m_numChannels; }
 
-	unsigned int GetResolution(unsigned int channel) const;
+	inline unsigned int GetResolution(unsigned int channel) const { return m_resolutions[channel]; }
+	void GetPixelRange(unsigned int channel, float t1, float t2, int& outIndex1, int& outIndex2) const;
 	float GetSightValue(unsigned int channel, float t) const;
 	float GetSightValueAtIndex(unsigned int channel, unsigned int index) const;
 	float GetInterpolatedSightValue(unsigned int channel, float t) const;
 
 	void ClearSightValues();
-	void SetSightValue(unsigned int channel, unsigned int index, float sightValue, float depth);
+	inline void SetSightValue(unsigned int channel, unsigned int index, float sightValue, float depth);
 
+	inline const Matrix4f& GetAgentToEye() const { return m_agentToEye; }
 	inline const Matrix4f& GetWorldToEye() const { return m_worldToEye; }
 	inline const Matrix4f& GetEyeToProjection() const { return m_eyeToProjection; }
-	inline void SetWorldToEye(const Matrix4f& worldToEye) { m_worldToEye = worldToEye; }
-	inline void SetEyeToProjection(const Matrix4f& eyeToProjection) { m_eyeToProjection = eyeToProjection; }
+
+	// Update the world-to-eye matrix from the agent's world-to-object matrix.
+	inline void UpdateWorldToEye(const Matrix4f& worldToAgent) { m_worldToEye = m_agentToEye * worldToAgent; }
 
 private:
 	float			m_fieldOfView; // in radians.
+	float			m_invFieldOfView;
+	float			m_centerAngle; // Angle the eye looks at in agent-space, in radians. Positive is to the right.
 	float			m_viewDistance;
 	unsigned int	m_numChannels;
-	VisionChannel*	m_channels;
+	unsigned int	m_resolutions[MAX_CHANNELS];
+	unsigned int	m_channelStride;
+	float*			m_colorBuffer; // color values for each pixel
+	float*			m_depthBuffer; // depth values for each pixel. 0 = close, 1 = far.
+	Matrix4f		m_agentToEye; // Converts points from agent-space to eye-space.
 	Matrix4f		m_worldToEye; // Converts points from world-space to eye-space.
 	Matrix4f		m_eyeToProjection; // Converts points from eye-space to eye-projection-space.
 };
 
 
+//-----------------------------------------------------------------------------
+// RetinaCoverage - Tracks which pixels of a retina have been drawn, so that
+//                  objects drawn front to back can skip covered pixels.
+//-----------------------------------------------------------------------------
+class RetinaCoverage
+{
+public:
+	static const unsigned int MAX_RESOLUTION = 64;
+
+	// Mark all of the retina's pixels as uncovered.
+	void Reset(const Retina& retina);
+
+	// Draw the span [t1, t2] with the given color, writing only the pixels
+	// which are not covered yet. Spans must be drawn nearest first.
+	void DrawSpan(Retina& retina, const Vector3f& color, float t1, float t2, float depth);
+
+	// Returns true if every pixel of the retina has been covered.
+	inline bool IsSaturated() const { return (m_numUncoveredChannels == 0); }
+
+private:
+	unsigned long long	m_coveredMasks[Retina::MAX_CHANNELS];
+	unsigned long long	m_fullMasks[Retina::MAX_CHANNELS];
+	unsigned int		m_numUncoveredChannels;
+};
+
+
+//-----------------------------------------------------------------------------
+// VisionCuller - Cheap early rejects for objects which an agent can not see,
+//                done before any projection math. The cone test is
+//                conservative: objects it rejects would not have drawn any
+//                pixels. The horizon test is not, as the projections ignore
+//                the world, so objects below the horizon are otherwise seen
+//                through it. Enabling it changes what agents see.
+//-----------------------------------------------------------------------------
+class VisionCuller
+{
+public:
+	VisionCuller();
+
+	// Setup the tests for an agent's eyes. The combined eye cone is the
+	// angle from the agent's forward direction to the outer edge of its
+	// eyes. The eyes are at the given height above the world's center.
+	void Setup(const Matrix4f& worldToAgent, float coneHalfAngle,
+		float eyeHeight, float worldRadius, bool cullBehind,
+		bool cullBeyondHorizon);
+
+	// Returns true if the object lies entirely outside the eye cone, as
+	// measured in the plane of the agent's retinas.
+	inline bool IsOutsideCone(const Vector3f& position, float radius, float distance) const;
+
+	// Returns true if the world's surface blocks the line of sight from the
+	// eyes to the top of the object.
+	inline bool IsBeyondHorizon(const Vector3f& position, float radius, float distance) const;
+
+private:
+	Matrix4f	m_worldToAgent;
+	float		m_coneCos;
+	float		m_coneSin;
+	float		m_worldRadiusSqr;
+	float		m_eyeHorizonDistance;
+	bool		m_cullBehind;
+	bool		m_cullBeyondHorizon;
+};
+
+
+// Write a sight value into a pixel if it passes the depth test.
+inline void Retina::SetSightValue(unsigned int channel, unsigned int index, float sightValue, float depth)
+{
+	assert(channel < m_numChannels);
+	assert(index < m_resolutions[channel]);
+
+	unsigned int pixel = (channel * m_channelStride) + index;
+	if (depth < m_depthBuffer[pixel])
+	{
+		m_colorBuffer[pixel] = sightValue;
+		m_depthBuffer[pixel] = depth;
+	}
+}
+
+inline bool VisionCuller::IsOutsideCone(const Vector3f& position, float radius, float distance) const
+{
+	if (!m_cullBehind)
+		return false;
+
+	// Measure the distance from the object's center to the nearest edge of
+	// the cone, in the same agent-space used by the projection. Leave a small
+	// angular margin for the approximate arc tangents of the batch kernel.
+	Vector3f posInAgent = m_worldToAgent.Multiply4x3(position);
+	float forwardDist = -posInAgent.z;
+	float sideDist = Math::Abs(posInAgent.x);
+	float edgeDist = (sideDist * m_coneCos) - (forwardDist * m_coneSin);
+	return (edgeDist > radius + (distance * 0.001f));
+}
+
+inline bool VisionCuller::IsBeyondHorizon(const Vector3f& position, float radius, float distance) const
+{
+	// The object's horizon distance is never negative, so objects nearer
+	// than the eyes' horizon can always be seen.
+	if (!m_cullBeyondHorizon || distance <= m_eyeHorizonDistance)
+		return false;
+
+	// The furthest the eyes can see the object is the sum of the distances
+	// from each of them to the horizon.
+	float objectHeight = position.Length() + radius;
+	float objectHorizonDistSqr = (objectHeight * objectHeight) - m_worldRadiusSqr;
+	float objectHorizonDist = (objectHorizonDistSqr > 0.0f ?
+		Math::Sqrt(objectHorizonDistSqr) : 0.0f);
+	return (distance > m_eyeHorizonDistance + objectHorizonDist);
+}
+
+
 #endif // _VISION_H_
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "VisionBatch.h"
+#include <math/MathLib.h>
+#include <utilities/SIMD.h>
+#include <algorithm>
+#include <string.h>
+
+
+//-----------------------------------------------------------------------------
+// Projection kernel
+//-----------------------------------------------------------------------------
+
+// The kernel is written once as a template over the lane type, so the scalar
+// fallback performs exactly the same operations as the SIMD versions.
+
+// Approximate atan2(y, x) over the full circle (max error about 1e-7 radians).
+template <class L>
+static inline typename L::Type ApproxATan2(typename L::Type y, typename L::Type x)
+{
+	typedef typename L::Type V;
+
+	// Reduce the angle to the range [0, pi/4].
+	V absX = L::Abs(x);
+	V absY = L::Abs(y);
+	V a = L::Div(L::Min(absX, absY),
+		L::Max(L::Max(absX, absY), L::Set(1e-30f)));
+	V s = L::Mul(a, a);
+
+	// Polynomial approximation of atan(a).
+	V r = L::Set(-0.01172120f);
+	r = L::Add(L::Mul(r, s), L::Set(0.05265332f));
+	r = L::Add(L::Mul(r, s), L::Set(-0.11643287f));
+	r = L::Add(L::Mul(r, s), L::Set(0.19354346f));
+	r = L::Add(L::Mul(r, s), L::Set(-0.33262347f));
+	r = L::Add(L::Mul(r, s), L::Set(0.99997726f));
+	r = L::Mul(r, a);
+
+	// Expand back into the full circle.
+	r = L::Select(L::Greater(absY, absX), L::Sub(L::Set(Math::HALF_PI), r), r);
+	r = L::Select(L::Less(x, L::Set(0.0f)), L::Sub(L::Set(Math::PI), r), r);
+	r = L::Select(L::Less(y, L::Set(0.0f)), L::Negate(r), r);
+	return r;
+}
+
+// Approximate asin(x) for x in the range [0, 1] (max error about 2e-8 radians).
+template <class L>
+static inline typename L::Type ApproxASin(typename L::Type x)
+{
+	typedef typename L::Type V;
+
+	V r = L::Set(-0.0012624911f);
+	r = L::Add(L::Mul(r, x), L::Set(0.0066700901f));
+	r = L::Add(L::Mul(r, x), L::Set(-0.0170881256f));
+	r = L::Add(L::Mul(r, x), L::Set(0.0308918810f));
+	r = L::Add(L::Mul(r, x), L::Set(-0.0501743046f));
+	r = L::Add(L::Mul(r, x), L::Set(0.0889789874f));
+	r = L::Add(L::Mul(r, x), L::Set(-0.2145988016f));
+	r = L::Add(L::Mul(r, x), L::Set(1.5707963050f));
+	return L::Sub(L::Set(Math::HALF_PI),
+		L::Mul(L::Sqrt(L::Sub(L::Set(1.0f), x)), r));
+}
+
+// Project objects [begin, end) onto each eye, L::WIDTH objects at a time.
+template <class L>
+static void ProjectObjects(const VisionBatchParams& params,
+	const float* inX, const float* inY, const float* inZ, const float* inRadius,
+	float* outDepth, float* const* outSpanBegin, float* const* outSpanEnd,
+	unsigned int begin, unsigned int end)
+{
+	typedef typename L::Type V;
+	typedef typename L::Mask M;
+
+	const float* m = params.worldToAgent.m;
+	const V zero = L::Set(0.0f);
+	const V half = L::Set(0.5f);
+	const V one = L::Set(1.0f);
+	const V pi = L::Set(Math::PI);
+	const V twoPi = L::Set(Math::TWO_PI);
+	const V agentX = L::Set(params.agentPosition.x);
+	const V agentY = L::Set(params.agentPosition.y);
+	const V agentZ = L::Set(params.agentPosition.z);
+	const V viewDistance = L::Set(params.viewDistance);
+	const V viewDistanceSqr = L::Set(params.viewDistance * params.viewDistance);
+	const V outOfRangeDepth = L::Set(2.0f);
+
+	for (unsigned int i = begin; i < end; i += L::WIDTH)
+	{
+		V x = L::Load(inX + i);
+		V y = L::Load(inY + i);
+		V z = L::Load(inZ + i);
+		V radius = L::Load(inRadius + i);
+		V radiusSqr = L::Mul(radius, radius);
+
+		// Distance from the agent to the object.
+		V dx = L::Sub(x, agentX);
+		V dy = L::Sub(y, agentY);
+		V dz = L::Sub(z, agentZ);
+		V distSqr = L::Add(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), L::Mul(dz, dz));
+
+		// Transform the object into agent-space, where the agent looks down
+		// the negative z-axis. The vertical axis is not needed.
+		V agentSpaceX = L::Add(L::Add(L::Add(L::Mul(L::Set(m[0]), x),
+			L::Mul(L::Set(m[4]), y)), L::Mul(L::Set(m[8]), z)), L::Set(m[12]));
+		V agentSpaceZ = L::Add(L::Add(L::Add(L::Mul(L::Set(m[2]), x),
+			L::Mul(L::Set(m[6]), y)), L::Mul(L::Set(m[10]), z)), L::Set(m[14]));
+		V planarDistSqr = L::Add(L::Mul(agentSpaceX, agentSpaceX),
+			L::Mul(agentSpaceZ, agentSpaceZ));
+
+		// Compute the angle and angular radius in the agent's xz-plane.
+		V angle = ApproxATan2<L>(agentSpaceX, L::Negate(agentSpaceZ));
+		V sinAngularRadius = L::Min(L::Div(radius, L::Sqrt(planarDistSqr)), one);
+		V angularRadius = L::Select(L::Greater(planarDistSqr, radiusSqr),
+			ApproxASin<L>(sinAngularRadius), pi);
+		V depth = L::Div(L::Sqrt(distSqr), viewDistance);
+
+		// If we are inside the object, then it fills all of our vision.
+		M isOutside = L::Greater(distSqr, radiusSqr);
+		angle = L::Select(isOutside, angle, zero);
+		angularRadius = L::Select(isOutside, angularRadius, pi);
+		depth = L::Select(isOutside, depth, zero);
+
+		// Mark objects beyond the view distance.
+		depth = L::Select(L::Greater(distSqr, viewDistanceSqr), outOfRangeDepth, depth);
+		L::Store(outDepth + i, depth);
+
+		// Compute the object's span on each eye.
+		for (unsigned int eye = 0; eye < params.numEyes; ++eye)
+		{
+			V invFieldOfView = L::Set(params.eyeInvFieldOfView[eye]);
+			V angleInEye = L::Sub(angle, L::Set(params.eyeCenterAngle[eye]));
+			angleInEye = L::Select(L::Greater(angleInEye, pi),
+				L::Sub(angleInEye, twoPi), angleInEye);
+			angleInEye = L::Select(L::Less(angleInEye, L::Negate(pi)),
+				L::Add(angleInEye, twoPi), angleInEye);
+
+			L::Store(outSpanBegin[eye] + i, L::Add(L::Mul(
+				L::Sub(angleInEye, angularRadius), invFieldOfView), half));
+			L::Store(outSpanEnd[eye] + i, L::Add(L::Mul(
+				L::Add(angleInEye, angularRadius), invFieldOfView), half));
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+VisionBatch::VisionBatch() :
+	m_numObjects(0),
+	m_capacity(0),
+	m_buffer(nullptr)
+{
+	Reserve(256);
+}
+
+VisionBatch::~VisionBatch()
+{
+	delete [] m_buffer;
+	m_buffer = nullptr;
+}
+
+
+//-----------------------------------------------------------------------------
+// Gathering
+//-----------------------------------------------------------------------------
+
+void VisionBatch::Clear()
+{
+	m_numObjects = 0;
+}
+
+void VisionBatch::AddObject(const Vector3f& position, float radius, const Vector3f& color)
+{
+	if (m_numObjects == m_capacity)
+		Reserve(m_capacity * 2);
+
+	m_x[m_numObjects]		= position.x;
+	m_y[m_numObjects]		= position.y;
+	m_z[m_numObjects]		= position.z;
+	m_radius[m_numObjects]	= radius;
+	m_red[m_numObjects]		= color.x;
+	m_green[m_numObjects]	= color.y;
+	m_blue[m_numObjects]	= color.z;
+	m_numObjects++;
+}
+
+void VisionBatch::Reserve(unsigned int capacity)
+{
+	const unsigned int numInputArrays = 7;
+	const unsigned int numOutputArrays = 1 + (VisionBatchParams::MAX_EYES * 2);
+	const unsigned int numArrays = numInputArrays + (numOutputArrays * 2);
+
+	// Allocate all arrays in one block, keeping the gathered objects.
+	float* buffer = new float[capacity * numArrays];
+	if (m_buffer != nullptr)
+	{
+		for (unsigned int i = 0; i < numInputArrays; ++i)
+		{
+			memcpy(buffer + (i * capacity), m_buffer + (i * m_capacity),
+				m_numObjects * sizeof(float));
+		}
+		delete [] m_buffer;
+	}
+	m_buffer = buffer;
+	m_capacity = capacity;
+
+	float* array = m_buffer;
+	m_x			= array; array += capacity;
+	m_y			= array; array += capacity;
+	m_z			= array; array += capacity;
+	m_radius	= array; array += capacity;
+	m_red		= array; array += capacity;
+	m_green		= array; array += capacity;
+	m_blue		= array; array += capacity;
+
+	ProjectionOutput* outputs[2] = { &m_output, &m_verifyOutput };
+	for (unsigned int i = 0; i < 2; ++i)
+	{
+		outputs[i]->depth = array; array += capacity;
+		for (unsigned int eye = 0; eye < VisionBatchParams::MAX_EYES; ++eye)
+		{
+			outputs[i]->spanBegin[eye] = array; array += capacity;
+			outputs[i]->spanEnd[eye] = array; array += capacity;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Projection
+//-----------------------------------------------------------------------------
+
+void VisionBatch::Project(const VisionBatchParams& params)
+{
+	ProjectSIMD(params, m_output);
+}
+
+unsigned int VisionBatch::ProjectAndVerify(const VisionBatchParams& params)
+{
+	ProjectScalar(params, m_verifyOutput, 0, m_numObjects);
+	ProjectSIMD(params, m_output);
+
+	// Count the objects whose results differ in any bit.
+	unsigned int numMismatches = 0;
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		bool isMatch = (memcmp(&m_output.depth[i],
+			&m_verifyOutput.depth[i], sizeof(float)) == 0);
+		for (unsigned int eye = 0; eye < params.numEyes; ++eye)
+		{
+			isMatch = isMatch && (memcmp(&m_output.spanBegin[eye][i],
+				&m_verifyOutput.spanBegin[eye][i], sizeof(float)) == 0);
+			isMatch = isMatch && (memcmp(&m_output.spanEnd[eye][i],
+				&m_verifyOutput.spanEnd[eye][i], sizeof(float)) == 0);
+		}
+		if (!isMatch)
+			numMismatches++;
+	}
+	return numMismatches;
+}
+
+void VisionBatch::SortVisibleByDepth(unsigned int numEyes)
+{
+	m_sortKeys.clear();
+
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		float depth = m_output.depth[i];
+		if (depth > 1.0f)
+			continue;
+
+		// Skip objects outside the field of view of every eye.
+		bool isVisible = false;
+		for (unsigned int eye = 0; eye < numEyes && !isVisible; ++eye)
+		{
+			isVisible = (m_output.spanEnd[eye][i] >= 0.0f &&
+				m_output.spanBegin[eye][i] < 1.0f);
+		}
+
+		// Depths are never negative, so their bits sort in the same
+		// order as their values.
+		if (isVisible)
+		{
+			unsigned int depthBits;
+			memcpy(&depthBits, &depth, sizeof(float));
+			m_sortKeys.push_back(((unsigned long long) depthBits << 32) | i);
+		}
+	}
+
+	std::sort(m_sortKeys.begin(), m_sortKeys.end());
+}
+
+const char* VisionBatch::GetInstructionSetName()
+{
+#if defined(SEAL_SIMD_AVX2)
+	return "AVX2";
+#elif defined(SEAL_SIMD_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+void VisionBatch::ProjectScalar(const VisionBatchParams& params,
+	const ProjectionOutput& output, unsigned int begin, unsigned int end) const
+{
+	ProjectObjects<ScalarLanes>(params, m_x, m_y, m_z, m_radius,
+		output.depth, output.spanBegin, output.spanEnd, begin, end);
+}
+
+void VisionBatch::ProjectSIMD(const VisionBatchParams& params,
+	const ProjectionOutput& output) const
+{
+	// Process blocks of 8 objects with the widest available kernel, then
+	// finish the remainder with the scalar kernel.
+	unsigned int numBlocked = m_numObjects - (m_numObjects % 8);
+
+#if defined(SEAL_SIMD_AVX2)
+	ProjectObjects<AVX2Lanes>(params, m_x, m_y, m_z, m_radius,
+		output.depth, output.spanBegin, output.spanEnd, 0, numBlocked);
+#elif defined(SEAL_SIMD_SSE2)
+	ProjectObjects<SSELanes>(params, m_x, m_y, m_z, m_radius,
+		output.depth, output.spanBegin, output.spanEnd, 0, numBlocked);
+#else
+	numBlocked = 0;
+#endif
+
+	ProjectScalar(params, output, numBlocked, m_numObjects);
+}
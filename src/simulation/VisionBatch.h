@@ -0,0 +1,114 @@
+#ifndef _VISION_BATCH_H_
+#define _VISION_BATCH_H_
+
+#include <math/Matrix4f.h>
+#include <math/Vector3f.h>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// VisionBatchParams - The agent and eye values needed to project a batch of
+//                     objects onto an agent's retinas.
+//-----------------------------------------------------------------------------
+struct VisionBatchParams
+{
+	static const unsigned int MAX_EYES = 2;
+
+	Matrix4f		worldToAgent;
+	Vector3f		agentPosition;
+	float			viewDistance;
+	unsigned int	numEyes;
+	float			eyeCenterAngle[MAX_EYES]; // in radians. Positive is to the right.
+	float			eyeInvFieldOfView[MAX_EYES]; // 1 / field of view in radians.
+};
+
+
+//-----------------------------------------------------------------------------
+// VisionBatch - Gathers the objects near an agent into SoA arrays, then
+//               computes the span and depth of each object on each eye
+//               several objects at a time using SIMD kernels.
+//-----------------------------------------------------------------------------
+class VisionBatch
+{
+public:
+	VisionBatch();
+	~VisionBatch();
+
+	//-------------------------------------------------------------------------
+	// Gathering
+
+	void Clear();
+	void AddObject(const Vector3f& position, float radius, const Vector3f& color);
+
+	//-------------------------------------------------------------------------
+	// Projection
+
+	// Project all gathered objects onto the eyes. Objects outside the view
+	// distance are given a depth greater than one.
+	void Project(const VisionBatchParams& params);
+
+	// Project all gathered objects with both the scalar and SIMD kernels,
+	// and return the number of objects whose results are not bitwise
+	// identical. The SIMD results are kept.
+	unsigned int ProjectAndVerify(const VisionBatchParams& params);
+
+	// Sort the projected objects which are visible to any eye by depth,
+	// nearest first. Objects with equal depths keep their gathered order.
+	void SortVisibleByDepth(unsigned int numEyes);
+
+	//-------------------------------------------------------------------------
+	// Getters
+
+	inline unsigned int GetNumObjects() const { return m_numObjects; }
+	inline Vector3f GetPosition(unsigned int index) const { return Vector3f(m_x[index], m_y[index], m_z[index]); }
+	inline float GetRadius(unsigned int index) const { return m_radius[index]; }
+	inline float GetDepth(unsigned int index) const { return m_output.depth[index]; }
+	inline float GetSpanBegin(unsigned int eye, unsigned int index) const { return m_output.spanBegin[eye][index]; }
+	inline float GetSpanEnd(unsigned int eye, unsigned int index) const { return m_output.spanEnd[eye][index]; }
+	inline Vector3f GetColor(unsigned int index) const { return Vector3f(m_red[index], m_green[index], m_blue[index]); }
+	inline unsigned int GetNumSorted() const { return (unsigned int) m_sortKeys.size(); }
+	inline unsigned int GetSortedIndex(unsigned int order) const { return (unsigned int) (m_sortKeys[order] & 0xFFFFFFFFull); }
+
+	// Returns the name of the SIMD instruction set the kernels were compiled for.
+	static const char* GetInstructionSetName();
+
+private:
+	// Output arrays for the projected objects.
+	struct ProjectionOutput
+	{
+		float* depth;
+		float* spanBegin[VisionBatchParams::MAX_EYES];
+		float* spanEnd[VisionBatchParams::MAX_EYES];
+	};
+
+	void Reserve(unsigned int capacity);
+	void ProjectScalar(const VisionBatchParams& params,
+		const ProjectionOutput& output, unsigned int begin, unsigned int end) const;
+	void ProjectSIMD(const VisionBatchParams& params,
+		const ProjectionOutput& output) const;
+
+	unsigned int	m_numObjects;
+	unsigned int	m_capacity;
+	float*			m_buffer; // All arrays are allocated in one block.
+
+	// Gathered objects.
+	float*			m_x;
+	float*			m_y;
+	float*			m_z;
+	float*			m_radius;
+	float*			m_red;
+	float*			m_green;
+	float*			m_blue;
+
+	// Projected objects, and a second copy used for verification. Spans are
+	// in retina-space, where 0 to 1 is within the field of view.
+	ProjectionOutput m_output;
+	ProjectionOutput m_verifyOutput;
+
+	// Depth-sorted visible objects. The depth's bits are in the upper half
+	// of each key and the object index is in the lower half.
+	std::vector<unsigned long long> m_sortKeys;
+};
+
+
+#endif // _VISION_BATCH_H_
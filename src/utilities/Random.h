@@ -127,6 +127,17 @@ public:
 	//-------------------------------------------------------------------------
 	// Seeding 
 
+	// Mix a value into a seed. This derives seeds for separate streams of
+	// random numbers (such as one for each agent on each tick), which don't
+	// depend on the order in which the streams are used.
+	static inline unsigned long MixSeed(unsigned long seed, unsigned long value)
+	{
+		unsigned int x = (unsigned int) seed ^ ((unsigned int) value * 0x9E3779B9u);
+		x = (x ^ (x >> 16)) * 0x85EBCA6Bu;
+		x = (x ^ (x >> 13)) * 0xC2B2AE35u;
+		return (unsigned long) (x ^ (x >> 16));
+	}
+
 	// Set the current seed to the given number.
 	inline void SetSeed(unsigned long seed)
     {
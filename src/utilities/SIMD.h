@@ -0,0 +1,136 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <cmath>
+#include <string.h>
+
+// Detect the widest SIMD instruction set enabled for this build.
+// (AVX2 requires /arch:AVX2, SSE2 is the default for x86 and x64.)
+#if defined(__AVX2__)
+	#define SEAL_SIMD_AVX2
+	#define SEAL_SIMD_SSE2
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SEAL_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+// NOTE: Each lane type below exposes the same set of operations, so a kernel
+// written as a template over the lane type compiles to the same sequence of
+// IEEE operations for every width. This is what keeps the SIMD kernels
+// bitwise identical to their scalar fallbacks (as long as the compiler does
+// not contract multiplies and adds into fused multiply-adds). Sum() adds the
+// lanes in a different order for each width, so kernels which reduce across
+// lanes only match their scalar fallbacks approximately.
+//
+// Round() rounds to the nearest integer (ties to even), and Pow2() computes
+// 2^n for an integral n within the normal float exponent range.
+
+
+//-----------------------------------------------------------------------------
+// ScalarLanes - A single float lane, used as the scalar fallback.
+//-----------------------------------------------------------------------------
+struct ScalarLanes
+{
+	typedef float Type;
+	typedef bool Mask;
+	static const unsigned int WIDTH = 1;
+
+	static inline Type Set(float x) { return x; }
+	static inline Type Load(const float* p) { return *p; }
+	static inline void Store(float* p, Type a) { *p = a; }
+	static inline Type Add(Type a, Type b) { return a + b; }
+	static inline Type Sub(Type a, Type b) { return a - b; }
+	static inline Type Mul(Type a, Type b) { return a * b; }
+	static inline Type Div(Type a, Type b) { return a / b; }
+	static inline Type Sqrt(Type a) { return std::sqrt(a); }
+	static inline Type Min(Type a, Type b) { return (a < b ? a : b); }
+	static inline Type Max(Type a, Type b) { return (a > b ? a : b); }
+	static inline Type Abs(Type a) { return std::fabs(a); }
+	static inline Type Negate(Type a) { return -a; }
+	static inline Mask Greater(Type a, Type b) { return (a > b); }
+	static inline Mask Less(Type a, Type b) { return (a < b); }
+	static inline Mask And(Mask a, Mask b) { return (a && b); }
+	static inline Type Select(Mask m, Type a, Type b) { return (m ? a : b); }
+	static inline Type Round(Type a) { return std::nearbyint(a); }
+	static inline Type Pow2(Type n) { int bits = ((int) n + 127) << 23; float x; memcpy(&x, &bits, sizeof(float)); return x; }
+	static inline float Sum(Type a) { return a; }
+};
+
+
+#ifdef SEAL_SIMD_SSE2
+
+//-----------------------------------------------------------------------------
+// SSELanes - Four float lanes using SSE2.
+//-----------------------------------------------------------------------------
+struct SSELanes
+{
+	typedef __m128 Type;
+	typedef __m128 Mask;
+	static const unsigned int WIDTH = 4;
+
+	static inline Type Set(float x) { return _mm_set1_ps(x); }
+	static inline Type Load(const float* p) { return _mm_loadu_ps(p); }
+	static inline void Store(float* p, Type a) { _mm_storeu_ps(p, a); }
+	static inline Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+	static inline Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+	static inline Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+	static inline Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+	static inline Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+	static inline Type Min(Type a, Type b) { return _mm_min_ps(a, b); }
+	static inline Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+	static inline Type Abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static inline Type Negate(Type a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+	static inline Mask Greater(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+	static inline Mask Less(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+	static inline Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+	static inline Type Select(Mask m, Type a, Type b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	static inline Type Round(Type a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+	static inline Type Pow2(Type n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23)); }
+	static inline float Sum(Type a)
+	{
+		Type pairs = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+	}
+};
+
+#endif // SEAL_SIMD_SSE2
+
+
+#ifdef SEAL_SIMD_AVX2
+
+//-----------------------------------------------------------------------------
+// AVX2Lanes - Eight float lanes using AVX2.
+//-----------------------------------------------------------------------------
+struct AVX2Lanes
+{
+	typedef __m256 Type;
+	typedef __m256 Mask;
+	static const unsigned int WIDTH = 8;
+
+	static inline Type Set(float x) { return _mm256_set1_ps(x); }
+	static inline Type Load(const float* p) { return _mm256_loadu_ps(p); }
+	static inline void Store(float* p, Type a) { _mm256_storeu_ps(p, a); }
+	static inline Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+	static inline Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+	static inline Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+	static inline Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+	static inline Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+	static inline Type Min(Type a, Type b) { return _mm256_min_ps(a, b); }
+	static inline Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+	static inline Type Abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static inline Type Negate(Type a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+	static inline Mask Greater(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static inline Mask Less(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static inline Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+	static inline Type Select(Mask m, Type a, Type b) { return _mm256_blendv_ps(b, a, m); }
+	static inline Type Round(Type a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static inline Type Pow2(Type n) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23)); }
+	static inline float Sum(Type a) { return SSELanes::Sum(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1))); }
+};
+
+#endif // SEAL_SIMD_AVX2
+
+
+#endif // _SIMD_H_
@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+
+//-----------------------------------------------------------------------------
+// Constructor & destructor
+//-----------------------------------------------------------------------------
+
+ThreadPool::ThreadPool() :
+	m_loopIndex(0),
+	m_numBusyWorkers(0),
+	m_isTerminating(false),
+	m_func(nullptr),
+	m_count(0),
+	m_chunkSize(1),
+	m_nextChunk(0)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+	Terminate();
+}
+
+void ThreadPool::Initialize(unsigned int numThreads)
+{
+	Terminate();
+
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0)
+		numThreads = 1;
+
+	// Start the workers at the current loop, so they don't take the last
+	// loop run by the previous workers for a new one.
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_isTerminating = false;
+	for (unsigned int i = 1; i < numThreads; ++i)
+		m_workers.push_back(std::thread(&ThreadPool::WorkerMain, this, m_loopIndex));
+}
+
+void ThreadPool::Terminate()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isTerminating = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (unsigned int i = 0; i < m_workers.size(); ++i)
+		m_workers[i].join();
+	m_workers.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+// Parallel loops
+//-----------------------------------------------------------------------------
+
+void ThreadPool::ParallelFor(unsigned int count, unsigned int chunkSize, const RangeFunc& func)
+{
+	if (count == 0)
+		return;
+	if (chunkSize == 0)
+		chunkSize = 1;
+
+	// Run small loops, or all loops without workers, on this thread.
+	if (m_workers.empty() || count <= chunkSize)
+	{
+		for (unsigned int begin = 0; begin < count; begin += chunkSize)
+			func(begin, (count - begin > chunkSize ? begin + chunkSize : count));
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = &func;
+		m_count = count;
+		m_chunkSize = chunkSize;
+		m_nextChunk = 0;
+		m_numBusyWorkers = m_workers.size();
+		m_loopIndex++;
+	}
+	m_workAvailable.notify_all();
+
+	RunChunks();
+
+	// Wait for the workers to finish their last chunks.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_workFinished.wait(lock, [this]() { return (m_numBusyWorkers == 0); });
+	m_func = nullptr;
+}
+
+
+//-----------------------------------------------------------------------------
+// Private methods
+//-----------------------------------------------------------------------------
+
+void ThreadPool::WorkerMain(unsigned int loopIndex)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_workAvailable.wait(lock, [&]() {
+			return (m_isTerminating || m_loopIndex != loopIndex); });
+		if (m_isTerminating)
+			return;
+		loopIndex = m_loopIndex;
+
+		lock.unlock();
+		RunChunks();
+		lock.lock();
+
+		if (--m_numBusyWorkers == 0)
+			m_workFinished.notify_one();
+	}
+}
+
+void ThreadPool::RunChunks()
+{
+	unsigned int numChunks = (m_count + m_chunkSize - 1) / m_chunkSize;
+	while (true)
+	{
+		unsigned int chunk = m_nextChunk++;
+		if (chunk >= numChunks)
+			return;
+
+		unsigned int begin = chunk * m_chunkSize;
+		unsigned int end = begin + m_chunkSize;
+		if (end > m_count)
+			end = m_count;
+		(*m_func)(begin, end);
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// ThreadPool - A fixed set of worker threads which run loops in parallel.
+//              A loop is split into chunks of a fixed size, which only
+//              depends on the loop's count and chunk size, never on the
+//              number of threads. So as long as each chunk only writes its
+//              own data, the results are the same for any number of threads.
+//-----------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+	// Called with the range [begin, end) of a chunk of the loop.
+	typedef std::function<void(unsigned int begin, unsigned int end)> RangeFunc;
+
+	//-------------------------------------------------------------------------
+	// Constructor & destructor
+
+	ThreadPool();
+	~ThreadPool();
+
+	// Start the worker threads, stopping any previous ones. The thread which
+	// calls ParallelFor() also runs chunks, so it counts as one of the
+	// threads. A count of zero uses one thread per hardware thread.
+	void Initialize(unsigned int numThreads);
+
+	// Stop and join all worker threads.
+	void Terminate();
+
+	inline unsigned int GetNumThreads() const { return (m_workers.size() + 1); }
+
+	//-------------------------------------------------------------------------
+	// Parallel loops
+
+	// Run func over the range [0, count), in chunks of chunkSize, and wait
+	// for all chunks to finish. Must not be called from inside a chunk.
+	void ParallelFor(unsigned int count, unsigned int chunkSize, const RangeFunc& func);
+
+
+private:
+	// Run each new loop after the one with the given index.
+	void WorkerMain(unsigned int loopIndex);
+
+	// Run chunks of the current loop until there are none left.
+	void RunChunks();
+
+
+private:
+	std::vector<std::thread>	m_workers;
+	std::mutex					m_mutex;
+	std::condition_variable		m_workAvailable;
+	std::condition_variable		m_workFinished;
+	unsigned int				m_loopIndex; // Incremented for every new loop.
+	unsigned int				m_numBusyWorkers;
+	bool						m_isTerminating;
+
+	// The current loop.
+	const RangeFunc*			m_func;
+	unsigned int				m_count;
+	unsigned int				m_chunkSize;
+	std::atomic<unsigned int>	m_nextChunk;
+};
+
+
+#endif // _THREAD_POOL_H_